@@ -0,0 +1,55 @@
+// 基准测试共用的计时工具，每个基准是一个独立的程序：
+//     g++ -std=c++17 -O2 -I.. xxx.cpp -o xxx && ./xxx
+#ifndef SJTU_BENCH_HPP
+#define SJTU_BENCH_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+
+namespace bench {
+
+    // 让编译器认为x被用到了，结果不会被优化掉
+    template<class T>
+    inline void keep(const T& x) {
+        asm volatile("" : : "g"(&x) : "memory");
+    }
+
+    // 运行reps次f，返回最快一次的毫秒数
+    template<class F>
+    double best_ms(int reps, F f) {
+        double best = 1e300;
+        for (int r = 0; r != reps; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+            if (d.count() < best) best = d.count();
+        }
+        return best;
+    }
+
+    // 统计分配次数的分配器，计数按元素类型区分
+    template<class T>
+    struct counting_allocator {
+        using value_type = T;
+        static inline size_t allocations = 0;
+
+        counting_allocator() = default;
+        template<class U>
+        counting_allocator(const counting_allocator<U>&) { }
+
+        T* allocate(size_t n) {
+            ++allocations;
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        void deallocate(T* p, size_t) { ::operator delete(p); }
+
+        template<class U>
+        bool operator==(const counting_allocator<U>&) const { return true; }
+        template<class U>
+        bool operator!=(const counting_allocator<U>&) const { return false; }
+    };
+
+}
+
+#endif //SJTU_BENCH_HPP
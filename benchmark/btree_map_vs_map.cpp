@@ -0,0 +1,70 @@
+// btree_map 和红黑树 map 的对比：随机插入、查找、删除，以及按序遍历
+// 元素数从放得进缓存到放不进缓存，B+树每个节点放多个元素，缓存未命中少，遍历是顺着叶子链表扫
+//     g++ -std=c++17 -O2 -I.. btree_map_vs_map.cpp
+#include "btree_map.hpp"
+#include "map.hpp"
+#include "bench.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+struct result {
+    double insert, find, scan, erase;  // ns/op
+};
+
+template<class Map>
+result run(const std::vector<int>& keys, const std::vector<int>& queries) {
+    size_t n = keys.size();
+    result r;
+    r.insert = bench::best_ms(3, [&] {
+        Map m;
+        for (int k : keys) m.insert(sjtu::pair<const int, int>(k, k));
+        bench::keep(m);
+    }) * 1e6 / n;
+
+    Map m;
+    for (int k : keys) m.insert(sjtu::pair<const int, int>(k, k));
+    r.find = bench::best_ms(3, [&] {
+        size_t found = 0;
+        for (int q : queries) found += m.count(q);
+        bench::keep(found);
+    }) * 1e6 / queries.size();
+    r.scan = bench::best_ms(3, [&] {
+        long sum = 0;
+        for (typename Map::const_iterator it = m.cbegin(); it != m.cend(); ++it) sum += it->second;
+        bench::keep(sum);
+    }) * 1e6 / n;
+
+    // 删除会改变表，每次计时前重新建一张
+    r.erase = 1e300;
+    for (int rep = 0; rep != 3; ++rep) {
+        Map e;
+        for (int k : keys) e.insert(sjtu::pair<const int, int>(k, k));
+        double ms = bench::best_ms(1, [&] {
+            for (int k : queries) {
+                typename Map::iterator it = e.find(k);
+                if (it != e.end()) e.erase(it);
+            }
+        });
+        r.erase = std::min(r.erase, ms * 1e6 / queries.size());
+    }
+    return r;
+}
+
+int main() {
+    printf("%-9s %-8s %10s %10s %10s %10s   (ns/op)\n", "size", "", "insert", "find", "scan", "erase");
+    for (size_t n : {1000u, 100000u, 1000000u}) {
+        std::mt19937 rng(42);
+        std::vector<int> keys(n);
+        for (size_t i = 0; i != n; ++i) keys[i] = int(i * 2);
+        std::shuffle(keys.begin(), keys.end(), rng);
+        std::vector<int> queries(keys);  // 全部命中，顺序和插入不同
+        std::shuffle(queries.begin(), queries.end(), rng);
+
+        result b = run<sjtu::btree_map<int, int>>(keys, queries);
+        result m = run<sjtu::map<int, int>>(keys, queries);
+        printf("%-9zu %-8s %10.2f %10.2f %10.2f %10.2f\n", n, "btree", b.insert, b.find, b.scan, b.erase);
+        printf("%-9s %-8s %10.2f %10.2f %10.2f %10.2f\n", "", "map", m.insert, m.find, m.scan, m.erase);
+    }
+    return 0;
+}
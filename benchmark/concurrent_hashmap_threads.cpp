@@ -0,0 +1,49 @@
+// concurrent_hashmap 随线程数的扩展性，1 到 64 个线程，读多写少(90%查找)和读写各半两种负载
+// Shards=1 就是整张表一把读写锁，作为对照
+//     g++ -std=c++17 -O2 -pthread -I.. concurrent_hashmap_threads.cpp
+#include "concurrent_hashmap.hpp"
+#include "bench.hpp"
+#include <thread>
+#include <vector>
+
+const long keys = 1 << 16;
+const long total_ops = 1 << 22;  // 所有线程合计的操作数，线程越多每个线程做得越少
+
+// 返回每秒百万次操作
+template<size_t Shards>
+double run(int threads, unsigned write_percent) {
+    sjtu::concurrent_hashmap<long, long, std::hash<long>, std::equal_to<long>,
+                             std::allocator<sjtu::pair<long, long>>, Shards> m;
+    m.reserve(keys);
+    for (long i = 0; i != keys; ++i) m.insert(sjtu::pair<long, long>(i, i));
+    long per_thread = total_ops / threads;
+    double ms = bench::best_ms(3, [&] {
+        std::vector<std::thread> workers;
+        for (int t = 0; t != threads; ++t) {
+            workers.emplace_back([&, t] {
+                unsigned long x = 0x9e3779b97f4a7c15ull * (t + 1);
+                long found = 0, v;
+                for (long i = 0; i != per_thread; ++i) {
+                    x ^= x << 13, x ^= x >> 7, x ^= x << 17;  // xorshift
+                    long k = long(x % keys);
+                    if (x / keys % 100 < write_percent) m.insert_or_assign(k, i);
+                    else found += m.find(k, v);
+                }
+                bench::keep(found);
+            });
+        }
+        for (std::thread& w : workers) w.join();
+    });
+    return double(per_thread * threads) / ms / 1e3;
+}
+
+int main() {
+    printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+    printf("%-8s %14s %14s %14s %14s\n", "threads", "90/10 64shard", "90/10 1shard", "50/50 64shard", "50/50 1shard");
+    for (int threads : {1, 2, 4, 8, 16, 32, 64}) {
+        printf("%-8d %14.2f %14.2f %14.2f %14.2f\n", threads,
+               run<64>(threads, 10), run<1>(threads, 10), run<64>(threads, 50), run<1>(threads, 50));
+    }
+    printf("(Mops/s)\n");
+    return 0;
+}
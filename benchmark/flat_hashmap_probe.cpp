@@ -0,0 +1,53 @@
+// flat_hashmap 在不同负载因子、不同未命中比例下的查找耗时，linked_hashmap 作为对照
+// 比较控制字节的方式在编译时选定，分别编译两次对比 SWAR 和 SSE2：
+//     g++ -std=c++17 -O2 -I.. flat_hashmap_probe.cpp                     （SSE2）
+//     g++ -std=c++17 -O2 -I.. -DSJTU_HASH_SIMD=0 flat_hashmap_probe.cpp  （SWAR，两个64位整数）
+#include "flat_hashmap.hpp"
+#include "linked_hashmap.hpp"
+#include "bench.hpp"
+#include <random>
+#include <type_traits>
+#include <vector>
+
+const size_t slots = 1 << 20;   // 元素数在 (7/16, 7/8] * slots 之间时槽位数正好是slots
+const size_t queries = 1 << 21;
+
+// 前 n 个键插入表中（奇数），查询序列中 miss_percent% 是不在表中的键（偶数）
+struct workload {
+    std::vector<unsigned> keys, queries;
+
+    workload(size_t n, unsigned miss_percent) {
+        std::mt19937 rng(42);
+        for (size_t i = 0; i != n; ++i) keys.push_back(rng() | 1u);
+        for (size_t i = 0; i != ::queries; ++i) {
+            if (rng() % 100 < miss_percent) queries.push_back(rng() & ~1u);
+            else queries.push_back(keys[rng() % n]);
+        }
+    }
+};
+
+template<class Map>
+double run(const workload& w) {
+    Map m;
+    for (size_t i = 0; i != w.keys.size(); ++i) m[w.keys[i]] = int(i);
+    return bench::best_ms(3, [&] {
+        size_t found = 0;
+        for (unsigned q : w.queries) found += m.count(q);
+        bench::keep(found);
+    });
+}
+
+int main() {
+    bool portable = std::is_same<sjtu::detail::group, sjtu::detail::group_portable>::value;
+    printf("control byte matching: %s\n", portable ? "SWAR (portable)" : "SSE2");
+    printf("%-6s %-6s %14s %14s\n", "load", "miss%", "flat ns/op", "linked ns/op");
+    for (double load : {0.45, 0.65, 0.85}) {
+        for (unsigned miss : {0u, 40u, 100u}) {
+            workload w(size_t(load * slots), miss);
+            double flat = run<sjtu::flat_hashmap<unsigned, int>>(w);
+            double linked = run<sjtu::linked_hashmap<unsigned, int>>(w);
+            printf("%-6.2f %-6u %14.2f %14.2f\n", load, miss, flat * 1e6 / queries, linked * 1e6 / queries);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+// linked_hashmap 两种桶策略的对比：pow2_buckets（打散后按位与）和 modulo_buckets（直接取模）
+// 整数键用 std::hash，本身是恒等映射，步长为2的幂时不打散会全部挤进少数几个桶
+//     g++ -std=c++17 -O2 -I.. linked_hashmap_buckets.cpp
+#include "linked_hashmap.hpp"
+#include "bench.hpp"
+#include <string>
+#include <vector>
+
+const size_t n = 200000;
+
+template<class K, class Policy>
+using map_type = sjtu::linked_hashmap<K, int, std::hash<K>, std::equal_to<K>,
+                                      std::allocator<sjtu::pair<K, int>>, Policy>;
+
+// 返回 {插入, 查找} 每次操作的纳秒数
+template<class K, class Policy>
+std::pair<double, double> run(const std::vector<K>& keys) {
+    double insert = bench::best_ms(3, [&] {
+        map_type<K, Policy> m;
+        for (size_t i = 0; i != keys.size(); ++i) m[keys[i]] = int(i);
+        bench::keep(m);
+    });
+    map_type<K, Policy> m;
+    for (size_t i = 0; i != keys.size(); ++i) m[keys[i]] = int(i);
+    double find = bench::best_ms(3, [&] {
+        size_t found = 0;
+        for (const K& k : keys) found += m.count(k);
+        bench::keep(found);
+    });
+    return {insert * 1e6 / keys.size(), find * 1e6 / keys.size()};
+}
+
+template<class K>
+void report(const char* name, const std::vector<K>& keys) {
+    auto p = run<K, sjtu::pow2_buckets>(keys);
+    auto m = run<K, sjtu::modulo_buckets>(keys);
+    printf("%-16s %12.2f %12.2f %12.2f %12.2f\n", name, p.first, p.second, m.first, m.second);
+}
+
+int main() {
+    std::vector<long> dense, stride1024;
+    std::vector<std::string> strings;
+    for (size_t i = 0; i != n; ++i) {
+        dense.push_back(long(i));
+        stride1024.push_back(long(i) * 1024);
+        strings.push_back("key" + std::to_string(i));
+    }
+    printf("%-16s %12s %12s %12s %12s\n", "keys (ns/op)", "pow2 insert", "pow2 find", "mod insert", "mod find");
+    report("int dense", dense);
+    report("int stride 1024", stride1024);
+    report("string", strings);
+    return 0;
+}
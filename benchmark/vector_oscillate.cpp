@@ -0,0 +1,40 @@
+// 元素数在某个值附近来回变化时，不同扩容/缩容策略下push_back + erase的均摊开销和重新分配次数
+#include "vector.hpp"
+#include "bench.hpp"
+#include <vector>
+
+template<class Growth>
+using vec = sjtu::vector<int, bench::counting_allocator<int>, Growth>;
+
+// 先填到base个元素，再做rounds轮：push_back amplitude个，再从末尾erase amplitude个
+template<class V>
+void run(const char* name, size_t base, size_t amplitude, size_t rounds) {
+    size_t allocations = 0;
+    double ms = bench::best_ms(3, [&] {
+        V v;
+        for (size_t i = 0; i != base; ++i) v.push_back(int(i));
+        size_t before = bench::counting_allocator<int>::allocations;
+        for (size_t r = 0; r != rounds; ++r) {
+            for (size_t i = 0; i != amplitude; ++i) v.push_back(int(i));
+            for (size_t i = 0; i != amplitude; ++i) v.erase(v.end() - 1);
+        }
+        allocations = bench::counting_allocator<int>::allocations - before;
+        bench::keep(v.size());
+    });
+    printf("  %-18s %8.2f ns/op  %8zu allocations\n", name, ms * 1e6 / (2.0 * rounds * amplitude), allocations);
+}
+
+void run_all(size_t base, size_t amplitude, size_t rounds) {
+    printf("base=%zu amplitude=%zu\n", base, amplitude);
+    run<vec<sjtu::growth_2x>>("growth_2x", base, amplitude, rounds);
+    run<vec<sjtu::growth_1_5x>>("growth_1_5x", base, amplitude, rounds);
+    run<vec<sjtu::growth_no_shrink>>("growth_no_shrink", base, amplitude, rounds);
+    run<std::vector<int, bench::counting_allocator<int>>>("std::vector", base, amplitude, rounds);
+}
+
+int main() {
+    run_all(0, 1, 1000000);        // 在空和1个元素之间来回
+    run_all(1024, 1, 1000000);     // 正好在扩容边界上
+    run_all(256, 3840, 300);       // 大幅波动，每轮都跨过缩容阈值
+    return 0;
+}
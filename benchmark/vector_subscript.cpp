@@ -0,0 +1,79 @@
+// vector<double> 上的求和 / axpy 循环：operator[]、迭代器、at() 和裸数组对比
+// operator[] 默认不检查越界，应该和裸数组一样快（循环能被向量化）；
+// 加 -DSJTU_CHECKED_SUBSCRIPT=1 编译可以看到 operator[] 检查越界时的开销
+// 用 -O3 编译（GCC 的 -O2 不一定向量化）；浮点求和不允许重排，不加 -ffast-math 时哪种写法都不会向量化
+#include "vector.hpp"
+#include "bench.hpp"
+#include <memory>
+
+const size_t n = 1 << 16;
+const int rounds = 2000;
+
+void report(const char* name, double ms) {
+    printf("  %-12s %8.3f ns/element\n", name, ms * 1e6 / (double(n) * rounds));
+}
+
+int main() {
+    sjtu::vector<double> x, y;
+    std::unique_ptr<double[]> rx(new double[n]), ry(new double[n]);
+    for (size_t i = 0; i != n; ++i) {
+        x.push_back(i * 0.5);
+        y.push_back(i * 0.25);
+        rx[i] = i * 0.5;
+        ry[i] = i * 0.25;
+    }
+
+    printf("sum\n");
+    report("raw array", bench::best_ms(3, [&] {
+        for (int r = 0; r != rounds; ++r) {
+            double s = 0;
+            const double* p = rx.get();
+            for (size_t i = 0; i != n; ++i) s += p[i];
+            bench::keep(s);
+        }
+    }));
+    report("operator[]", bench::best_ms(3, [&] {
+        for (int r = 0; r != rounds; ++r) {
+            double s = 0;
+            for (size_t i = 0; i != n; ++i) s += x[i];
+            bench::keep(s);
+        }
+    }));
+    report("iterator", bench::best_ms(3, [&] {
+        for (int r = 0; r != rounds; ++r) {
+            double s = 0;
+            for (sjtu::vector<double>::const_iterator it = x.cbegin(); it != x.cend(); ++it) s += *it;
+            bench::keep(s);
+        }
+    }));
+    report("at()", bench::best_ms(3, [&] {
+        for (int r = 0; r != rounds; ++r) {
+            double s = 0;
+            for (size_t i = 0; i != n; ++i) s += x.at(i);
+            bench::keep(s);
+        }
+    }));
+
+    printf("axpy: y[i] = 1.5 * x[i] + y[i]\n");
+    report("raw array", bench::best_ms(3, [&] {
+        for (int r = 0; r != rounds; ++r) {
+            const double* px = rx.get();
+            double* py = ry.get();
+            for (size_t i = 0; i != n; ++i) py[i] = 1.5 * px[i] + py[i];
+            bench::keep(py[0]);
+        }
+    }));
+    report("operator[]", bench::best_ms(3, [&] {
+        for (int r = 0; r != rounds; ++r) {
+            for (size_t i = 0; i != n; ++i) y[i] = 1.5 * x[i] + y[i];
+            bench::keep(y[0]);
+        }
+    }));
+    report("at()", bench::best_ms(3, [&] {
+        for (int r = 0; r != rounds; ++r) {
+            for (size_t i = 0; i != n; ++i) y.at(i) = 1.5 * x.at(i) + y.at(i);
+            bench::keep(y[0]);
+        }
+    }));
+    return 0;
+}
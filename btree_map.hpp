@@ -0,0 +1,828 @@
+/**
+ * implement an ordered map like sjtu::map on top of a B+ tree
+ */
+#ifndef SJTU_BTREE_MAP_HPP
+#define SJTU_BTREE_MAP_HPP
+
+// only for std::less<T>
+#include <functional>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "config.hpp"
+#include "vector.hpp"
+
+namespace sjtu {
+
+    // 接口和 sjtu::map 相同的有序表，底层是B+树：
+    // 每个节点连续存放多个有序的键，查找每层只有一两次缓存缺失，树高约为红黑树的 1/4 ~ 1/5
+    // 元素都在叶子里，叶子串成双向链表，顺序遍历就是顺着链表扫数组
+    // CacheLines 控制节点大小：叶子放 CacheLines*64 字节的元素，内部节点放 CacheLines*64 字节的键，
+    // 每个节点的键数限制在 16 ~ 64 之间
+    // 插入和删除会在节点间搬动元素，迭代器和元素的引用都会失效（和 map 不同）
+    template<class Key, class T, class Compare = std::less<Key>,
+             class Allocator = std::allocator<pair<const Key, T>>, size_t CacheLines = 4>
+    class btree_map {
+    public:
+        using value_type = pair<const Key, T>;
+        using key_type = Key;
+        using mapped_type = T;
+        using size_type = size_t;
+        using allocator_type = Allocator;
+
+    private:
+        static constexpr size_type _clamp(size_type n) { return n < 16 ? 16 : (n > 64 ? 64 : n); }
+
+        static constexpr size_type leaf_cap = _clamp(CacheLines * 64 / sizeof(value_type));
+        static constexpr size_type internal_cap = _clamp(CacheLines * 64 / sizeof(Key));
+        static constexpr size_type leaf_min = leaf_cap / 2;          // 非根叶子至少这么多元素
+        static constexpr size_type internal_min = internal_cap / 2;  // 非根内部节点至少这么多键
+
+        struct Internal;
+
+        struct Node {
+            Internal* parent;
+            size_type count;  // 叶子：元素个数；内部节点：键的个数（孩子比键多一个）
+            bool leaf;
+        };
+
+        // 多留一个位置：插入后再分裂，节点平时最多存 leaf_cap 个
+        struct Leaf : Node {
+            Leaf* prev;
+            Leaf* next;
+            alignas(value_type) unsigned char data[(leaf_cap + 1) * sizeof(value_type)];
+
+            value_type* values() { return reinterpret_cast<value_type*>(data); }
+        };
+
+        // keys()[i] 是 children[i + 1] 子树中最小的键（删除后可能变小于它，仍能正确分流）
+        struct Internal : Node {
+            Node* children[internal_cap + 2];
+            alignas(Key) unsigned char data[(internal_cap + 1) * sizeof(Key)];
+
+            Key* keys() { return reinterpret_cast<Key*>(data); }
+        };
+
+        using alloc_traits = std::allocator_traits<Allocator>;
+        using leaf_allocator = typename alloc_traits::template rebind_alloc<Leaf>;
+        using internal_allocator = typename alloc_traits::template rebind_alloc<Internal>;
+        using key_allocator = typename alloc_traits::template rebind_alloc<Key>;
+        using leaf_traits = std::allocator_traits<leaf_allocator>;
+        using internal_traits = std::allocator_traits<internal_allocator>;
+
+        Allocator alloc_;
+        leaf_allocator leaf_alloc_;
+        internal_allocator internal_alloc_;
+        key_allocator key_alloc_;
+        size_type size_;
+        Compare comp_;
+        Node* root_;   // 空树时为nullptr，不分配任何节点
+        Leaf* first_;
+        Leaf* last_;
+
+    public:
+        struct const_iterator;
+        struct iterator {
+            btree_map* tree_;
+            Leaf* leaf_;        // end() 为nullptr
+            size_type index_;
+
+            iterator() = default;
+            iterator(btree_map* tree, Leaf* leaf, size_type index) :tree_(tree), leaf_(leaf), index_(index) { }
+            iterator(const iterator& other) = default;
+
+            value_type& operator*() const { return leaf_->values()[index_]; }
+            value_type* operator->() const { return leaf_->values() + index_; }
+
+            iterator& operator++() {
+                SJTU_CHECK_ITERATOR(tree_ == nullptr || leaf_ == nullptr);
+                if (++index_ == leaf_->count) {
+                    leaf_ = leaf_->next;
+                    index_ = 0;
+                }
+                return *this;
+            }
+
+            iterator operator++(int) {
+                iterator temp = *this;
+                ++*this;
+                return temp;
+            }
+
+            iterator& operator--() {
+                SJTU_CHECK_ITERATOR(tree_ == nullptr || (leaf_ ? leaf_ == tree_->first_ && index_ == 0 : tree_->last_ == nullptr));
+                if (leaf_ == nullptr) {
+                    leaf_ = tree_->last_;
+                    index_ = leaf_->count - 1;
+                }
+                else if (index_ == 0) {
+                    leaf_ = leaf_->prev;
+                    index_ = leaf_->count - 1;
+                }
+                else --index_;
+                return *this;
+            }
+
+            iterator operator--(int) {
+                iterator temp = *this;
+                --*this;
+                return temp;
+            }
+
+            bool operator==(const iterator& rhs) const { return leaf_ == rhs.leaf_ && index_ == rhs.index_; }
+            bool operator!=(const iterator& rhs) const { return !(*this == rhs); }
+            bool operator==(const const_iterator& rhs) const { return leaf_ == rhs.leaf_ && index_ == rhs.index_; }
+            bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+        };
+
+        struct const_iterator {
+            const btree_map* tree_;
+            Leaf* leaf_;
+            size_type index_;
+
+            const_iterator() = default;
+            const_iterator(const btree_map* tree, Leaf* leaf, size_type index) :tree_(tree), leaf_(leaf), index_(index) { }
+            const_iterator(const iterator& other) :tree_(other.tree_), leaf_(other.leaf_), index_(other.index_) { }
+            const_iterator(const const_iterator& other) = default;
+
+            const value_type& operator*() const { return leaf_->values()[index_]; }
+            const value_type* operator->() const { return leaf_->values() + index_; }
+
+            const_iterator& operator++() {
+                SJTU_CHECK_ITERATOR(tree_ == nullptr || leaf_ == nullptr);
+                if (++index_ == leaf_->count) {
+                    leaf_ = leaf_->next;
+                    index_ = 0;
+                }
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                const_iterator temp = *this;
+                ++*this;
+                return temp;
+            }
+
+            const_iterator& operator--() {
+                SJTU_CHECK_ITERATOR(tree_ == nullptr || (leaf_ ? leaf_ == tree_->first_ && index_ == 0 : tree_->last_ == nullptr));
+                if (leaf_ == nullptr) {
+                    leaf_ = tree_->last_;
+                    index_ = leaf_->count - 1;
+                }
+                else if (index_ == 0) {
+                    leaf_ = leaf_->prev;
+                    index_ = leaf_->count - 1;
+                }
+                else --index_;
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                const_iterator temp = *this;
+                --*this;
+                return temp;
+            }
+
+            bool operator==(const iterator& rhs) const { return leaf_ == rhs.leaf_ && index_ == rhs.index_; }
+            bool operator!=(const iterator& rhs) const { return !(*this == rhs); }
+            bool operator==(const const_iterator& rhs) const { return leaf_ == rhs.leaf_ && index_ == rhs.index_; }
+            bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+        };
+
+    private:
+
+#pragma region 节点分配与元素搬移
+
+        // 节点的元素/键区不构造，由 count 记录构造了多少个
+        Leaf* _new_leaf() {
+            Leaf* p = leaf_traits::allocate(leaf_alloc_, 1);
+            p->parent = nullptr;
+            p->count = 0;
+            p->leaf = true;
+            p->prev = p->next = nullptr;
+            return p;
+        }
+
+        Internal* _new_internal() {
+            Internal* p = internal_traits::allocate(internal_alloc_, 1);
+            p->parent = nullptr;
+            p->count = 0;
+            p->leaf = false;
+            return p;
+        }
+
+        void _delete_leaf(Leaf* p) {
+            for (size_type i = 0; i != p->count; ++i) alloc_traits::destroy(alloc_, p->values() + i);
+            leaf_traits::deallocate(leaf_alloc_, p, 1);
+        }
+
+        void _delete_internal(Internal* p) {
+            for (size_type i = 0; i != p->count; ++i) std::allocator_traits<key_allocator>::destroy(key_alloc_, p->keys() + i);
+            internal_traits::deallocate(internal_alloc_, p, 1);
+        }
+
+        void _delete_subtree(Node* pos) {
+            if (pos->leaf) {
+                _delete_leaf(static_cast<Leaf*>(pos));
+                return;
+            }
+            Internal* in = static_cast<Internal*>(pos);
+            for (size_type i = 0; i <= in->count; ++i) _delete_subtree(in->children[i]);
+            _delete_internal(in);
+        }
+
+        // [src, src + n) 搬到 dst，两段可以重叠
+        void _move_values(value_type* dst, value_type* src, size_type n) {
+            detail::relocate_overlap(alloc_, dst, src, n);
+        }
+
+        void _move_keys(Key* dst, Key* src, size_type n) {
+            detail::relocate_overlap(key_alloc_, dst, src, n);
+        }
+
+        void _move_children(Internal* dst, size_type to, Internal* src, size_type from, size_type n) {
+            std::memmove(dst->children + to, src->children + from, n * sizeof(Node*));
+            if (dst != src)
+                for (size_type i = to; i != to + n; ++i) dst->children[i]->parent = dst;
+        }
+
+        template<class... Args>
+        void _construct_key(Key* p, Args&&... args) {
+            std::allocator_traits<key_allocator>::construct(key_alloc_, p, std::forward<Args>(args)...);
+        }
+
+        void _destroy_key(Key* p) {
+            std::allocator_traits<key_allocator>::destroy(key_alloc_, p);
+        }
+#pragma endregion
+
+#pragma region 查找
+
+        // 第一个大于key的键的下标，即key所在的孩子
+        template<class K>
+        size_type _upper(Internal* in, const K& key) const {
+            size_type l = 0, r = in->count;
+            while (l < r) {
+                size_type mid = (l + r) / 2;
+                if (comp_(key, in->keys()[mid])) r = mid;
+                else l = mid + 1;
+            }
+            return l;
+        }
+
+        // 第一个不小于key的元素的下标
+        template<class K>
+        size_type _lower(Leaf* leaf, const K& key) const {
+            size_type l = 0, r = leaf->count;
+            while (l < r) {
+                size_type mid = (l + r) / 2;
+                if (comp_(leaf->values()[mid].first, key)) l = mid + 1;
+                else r = mid;
+            }
+            return l;
+        }
+
+        // 找到key应在的叶子和位置，返回true：找到了
+        template<class K>
+        bool _locate(const K& key, Leaf*& leaf, size_type& index) const {
+            leaf = nullptr;
+            index = 0;
+            if (root_ == nullptr) return false;
+            Node* pos = root_;
+            while (!pos->leaf) {
+                Internal* in = static_cast<Internal*>(pos);
+                pos = in->children[_upper(in, key)];
+            }
+            leaf = static_cast<Leaf*>(pos);
+            index = _lower(leaf, key);
+            return index != leaf->count && !comp_(key, leaf->values()[index].first);
+        }
+
+        size_type _child_index(Internal* parent, Node* child) const {
+            size_type i = 0;
+            while (parent->children[i] != child) ++i;
+            return i;
+        }
+#pragma endregion
+
+#pragma region 插入
+
+        // 插入导致的分裂要用到的新节点在改动树之前就分配好，分配失败时树还没动
+        // 备用的内部节点用 parent 串成链表，spare 指向表头
+        void _push_spare(Internal*& spare) {
+            Internal* p = _new_internal();
+            p->parent = spare;
+            spare = p;
+        }
+
+        Internal* _pop_spare(Internal*& spare) {
+            Internal* p = spare;
+            spare = static_cast<Internal*>(p->parent);
+            p->parent = nullptr;
+            return p;
+        }
+
+        void _free_spare(Internal* spare) {
+            while (spare) _delete_internal(_pop_spare(spare));
+        }
+
+        // 撤销刚在leaf的index处放入的元素
+        void _undo_insert(Leaf* leaf, size_type index) {
+            alloc_traits::destroy(alloc_, leaf->values() + index);
+            _move_values(leaf->values() + index, leaf->values() + index + 1, leaf->count - index - 1);
+            --leaf->count;
+            --size_;
+        }
+
+        // 复制出分裂后右边叶子的第一个键作为分隔键；Key的拷贝抛异常时撤销插入，释放备用节点
+        Key _copy_separator(Leaf* leaf, size_type index, size_type mid, Leaf* sibling, Internal* spare) {
+            try {
+                return Key(leaf->values()[mid].first);
+            }
+            catch (...) {
+                _undo_insert(leaf, index);
+                _delete_leaf(sibling);
+                _free_spare(spare);
+                throw;
+            }
+        }
+
+        // left 分裂出了 right，把分隔键 sep 插到父节点中，父节点满了继续向上分裂
+        // 要用的新内部节点从 spare 里取，这里不再分配
+        void _insert_parent(Node* left, Key&& sep, Node* right, Internal*& spare) {
+            Internal* parent = left->parent;
+            if (parent == nullptr) {  // 根分裂，树长高一层
+                Internal* newroot = _pop_spare(spare);
+                _construct_key(newroot->keys(), std::move(sep));
+                newroot->children[0] = left;
+                newroot->children[1] = right;
+                newroot->count = 1;
+                left->parent = right->parent = newroot;
+                root_ = newroot;
+                return;
+            }
+            size_type i = _child_index(parent, left);
+            _move_keys(parent->keys() + i + 1, parent->keys() + i, parent->count - i);
+            _move_children(parent, i + 2, parent, i + 1, parent->count - i);
+            _construct_key(parent->keys() + i, std::move(sep));
+            parent->children[i + 1] = right;
+            right->parent = parent;
+            if (++parent->count <= internal_cap) return;
+
+            // 满了：左边留下前 mid 个键，第 mid 个键上移，其余的给新节点
+            size_type mid = parent->count / 2;
+            Internal* sibling = _pop_spare(spare);
+            size_type moved = parent->count - mid - 1;
+            _move_keys(sibling->keys(), parent->keys() + mid + 1, moved);
+            _move_children(sibling, 0, parent, mid + 1, moved + 1);
+            sibling->count = moved;
+            Key up(std::move(parent->keys()[mid]));
+            _destroy_key(parent->keys() + mid);
+            parent->count = mid;
+            _insert_parent(parent, std::move(up), sibling, spare);
+        }
+
+        // 在leaf的index处放入新元素，满了就分裂
+        template<class V>
+        iterator _insert(Leaf* leaf, size_type index, V&& value) {
+            if (leaf == nullptr) {  // 空树
+                leaf = first_ = last_ = _new_leaf();
+                root_ = leaf;
+            }
+            // 放入后要分裂：先分配新叶子，以及沿途每个满的祖先（祖先全满时还有新根）各一个内部节点
+            Leaf* sibling = nullptr;
+            Internal* spare = nullptr;
+            if (leaf->count == leaf_cap) {
+                try {
+                    sibling = _new_leaf();
+                    Internal* p = leaf->parent;
+                    for (; p && p->count == internal_cap; p = p->parent) _push_spare(spare);
+                    if (p == nullptr) _push_spare(spare);
+                }
+                catch (...) {
+                    if (sibling) _delete_leaf(sibling);
+                    _free_spare(spare);
+                    throw;
+                }
+            }
+            _move_values(leaf->values() + index + 1, leaf->values() + index, leaf->count - index);
+            try {
+                alloc_traits::construct(alloc_, leaf->values() + index, std::forward<V>(value));
+            }
+            catch (...) {
+                _move_values(leaf->values() + index, leaf->values() + index + 1, leaf->count - index);
+                if (sibling) _delete_leaf(sibling);
+                _free_spare(spare);
+                if (size_ == 0) {
+                    _delete_leaf(leaf);
+                    root_ = first_ = last_ = nullptr;
+                }
+                throw;
+            }
+            ++size_;
+            if (++leaf->count <= leaf_cap) return iterator(this, leaf, index);
+
+            // 满了：一般对半分；在最后一个叶子末尾追加时左边全部留下，顺序插入时叶子是满的
+            size_type mid = (leaf == last_ && index == leaf_cap) ? leaf_cap : leaf->count / 2;
+            Key sep = _copy_separator(leaf, index, mid, sibling, spare);
+            _move_values(sibling->values(), leaf->values() + mid, leaf->count - mid);
+            sibling->count = leaf->count - mid;
+            leaf->count = mid;
+
+            sibling->prev = leaf;
+            sibling->next = leaf->next;
+            if (leaf->next) leaf->next->prev = sibling;
+            else last_ = sibling;
+            leaf->next = sibling;
+
+            _insert_parent(leaf, std::move(sep), sibling, spare);
+            if (index < mid) return iterator(this, leaf, index);
+            return iterator(this, sibling, index - mid);
+        }
+#pragma endregion
+
+#pragma region 删除
+
+        // 从内部节点中删掉第 i 个键和第 i + 1 个孩子
+        void _remove_from_internal(Internal* in, size_type i) {
+            _destroy_key(in->keys() + i);
+            _move_keys(in->keys() + i, in->keys() + i + 1, in->count - i - 1);
+            _move_children(in, i + 1, in, i + 2, in->count - i - 1);
+            --in->count;
+        }
+
+        void _erase(Leaf* leaf, size_type index) {
+            alloc_traits::destroy(alloc_, leaf->values() + index);
+            _move_values(leaf->values() + index, leaf->values() + index + 1, leaf->count - index - 1);
+            --leaf->count;
+            --size_;
+
+            if (leaf == root_) {
+                if (leaf->count == 0) {
+                    _delete_leaf(leaf);
+                    root_ = first_ = last_ = nullptr;
+                }
+                return;
+            }
+            if (leaf->count >= leaf_min) return;
+
+            Internal* parent = leaf->parent;
+            size_type i = _child_index(parent, leaf);
+            Leaf* left = i > 0 ? static_cast<Leaf*>(parent->children[i - 1]) : nullptr;
+            Leaf* right = i < parent->count ? static_cast<Leaf*>(parent->children[i + 1]) : nullptr;
+
+            if (left && left->count > leaf_min) {  // 向左兄弟借最后一个
+                _move_values(leaf->values() + 1, leaf->values(), leaf->count);
+                _move_values(leaf->values(), left->values() + left->count - 1, 1);
+                --left->count;
+                ++leaf->count;
+                _destroy_key(parent->keys() + i - 1);
+                _construct_key(parent->keys() + i - 1, leaf->values()[0].first);
+            }
+            else if (right && right->count > leaf_min) {  // 向右兄弟借第一个
+                _move_values(leaf->values() + leaf->count, right->values(), 1);
+                _move_values(right->values(), right->values() + 1, right->count - 1);
+                --right->count;
+                ++leaf->count;
+                _destroy_key(parent->keys() + i);
+                _construct_key(parent->keys() + i, right->values()[0].first);
+            }
+            else if (left) {
+                _merge_leaf(left, leaf, i - 1);
+            }
+            else {
+                _merge_leaf(leaf, right, i);
+            }
+        }
+
+        // 把right并入left，k是父节点中两者之间的分隔键
+        void _merge_leaf(Leaf* left, Leaf* right, size_type k) {
+            _move_values(left->values() + left->count, right->values(), right->count);
+            left->count += right->count;
+            right->count = 0;
+            left->next = right->next;
+            if (right->next) right->next->prev = left;
+            else last_ = left;
+            Internal* parent = left->parent;
+            _remove_from_internal(parent, k);
+            _delete_leaf(right);
+            _fix_internal(parent);
+        }
+
+        // 内部节点删掉一个键后，键太少时向兄弟借或合并
+        void _fix_internal(Internal* in) {
+            if (in == root_) {
+                if (in->count == 0) {  // 根只剩一个孩子，树变矮一层
+                    root_ = in->children[0];
+                    root_->parent = nullptr;
+                    _delete_internal(in);
+                }
+                return;
+            }
+            if (in->count >= internal_min) return;
+
+            Internal* parent = in->parent;
+            size_type i = _child_index(parent, in);
+            Internal* left = i > 0 ? static_cast<Internal*>(parent->children[i - 1]) : nullptr;
+            Internal* right = i < parent->count ? static_cast<Internal*>(parent->children[i + 1]) : nullptr;
+
+            if (left && left->count > internal_min) {  // 父节点的分隔键下移，左兄弟的最后一个键上移
+                _move_keys(in->keys() + 1, in->keys(), in->count);
+                _move_children(in, 1, in, 0, in->count + 1);
+                _move_keys(in->keys(), parent->keys() + i - 1, 1);
+                _move_children(in, 0, left, left->count, 1);
+                _move_keys(parent->keys() + i - 1, left->keys() + left->count - 1, 1);
+                --left->count;
+                ++in->count;
+            }
+            else if (right && right->count > internal_min) {  // 父节点的分隔键下移，右兄弟的第一个键上移
+                _move_keys(in->keys() + in->count, parent->keys() + i, 1);
+                _move_children(in, in->count + 1, right, 0, 1);
+                _move_keys(parent->keys() + i, right->keys(), 1);
+                _move_keys(right->keys(), right->keys() + 1, right->count - 1);
+                _move_children(right, 0, right, 1, right->count);
+                --right->count;
+                ++in->count;
+            }
+            else if (left) {
+                _merge_internal(left, in, i - 1);
+            }
+            else {
+                _merge_internal(in, right, i);
+            }
+        }
+
+        // 把right和父节点中的分隔键k并入left
+        void _merge_internal(Internal* left, Internal* right, size_type k) {
+            Internal* parent = left->parent;
+            _move_keys(left->keys() + left->count, parent->keys() + k, 1);
+            _move_keys(left->keys() + left->count + 1, right->keys(), right->count);
+            _move_children(left, left->count + 1, right, 0, right->count + 1);
+            left->count += right->count + 1;
+            right->count = 0;
+            // 分隔键已经搬走，不用再析构
+            _move_keys(parent->keys() + k, parent->keys() + k + 1, parent->count - k - 1);
+            _move_children(parent, k + 1, parent, k + 2, parent->count - k - 1);
+            --parent->count;
+            _delete_internal(right);
+            _fix_internal(parent);
+        }
+#pragma endregion
+
+        // 拷贝一棵子树，叶子按顺序接到 prev 之后；失败时释放这棵子树已经拷贝的部分
+        Node* _copy(Node* pos, Internal* parent, Leaf*& prev) {
+            if (pos->leaf) {
+                Leaf* src = static_cast<Leaf*>(pos);
+                Leaf* leaf = _new_leaf();
+                try {
+                    for (; leaf->count != src->count; ++leaf->count)
+                        alloc_traits::construct(alloc_, leaf->values() + leaf->count, src->values()[leaf->count]);
+                }
+                catch (...) {
+                    _delete_leaf(leaf);
+                    throw;
+                }
+                leaf->parent = parent;
+                leaf->prev = prev;
+                if (prev) prev->next = leaf;
+                else first_ = leaf;
+                prev = leaf;
+                return leaf;
+            }
+            Internal* src = static_cast<Internal*>(pos);
+            Internal* in = _new_internal();
+            in->parent = parent;
+            size_type copied = 0;  // 已经拷贝好的孩子数
+            try {
+                for (; in->count != src->count; ++in->count)
+                    _construct_key(in->keys() + in->count, src->keys()[in->count]);
+                for (; copied <= src->count; ++copied)
+                    in->children[copied] = _copy(src->children[copied], in, prev);
+            }
+            catch (...) {
+                for (size_type i = 0; i != copied; ++i) _delete_subtree(in->children[i]);
+                _delete_internal(in);
+                throw;
+            }
+            return in;
+        }
+
+        void _copy_from(const btree_map& other) {
+            if (other.root_ == nullptr) return;
+            Leaf* prev = nullptr;
+            root_ = _copy(other.root_, nullptr, prev);
+            last_ = prev;
+            last_->next = nullptr;
+            size_ = other.size_;
+        }
+
+        void _steal(btree_map& other) {
+            root_ = other.root_;
+            first_ = other.first_;
+            last_ = other.last_;
+            size_ = other.size_;
+            other.root_ = nullptr;
+            other.first_ = other.last_ = nullptr;
+            other.size_ = 0;
+        }
+
+    public:
+
+        btree_map() :btree_map(Allocator()) { }
+
+        explicit btree_map(const Allocator& alloc)
+            :alloc_(alloc), leaf_alloc_(alloc), internal_alloc_(alloc), key_alloc_(alloc),
+             size_(0), root_(nullptr), first_(nullptr), last_(nullptr) { }
+
+        btree_map(const btree_map& other)
+            :btree_map(alloc_traits::select_on_container_copy_construction(other.alloc_)) {
+            comp_ = other.comp_;
+            try {
+                _copy_from(other);
+            }
+            catch (...) {
+                root_ = first_ = last_ = nullptr;
+                throw;
+            }
+        }
+
+        // 只接管指针，不分配内存；放在vector等容器里扩容时会移动而不是逐个拷贝
+        btree_map(btree_map&& other) noexcept(std::is_nothrow_move_constructible<Compare>::value)
+            :alloc_(other.alloc_), leaf_alloc_(other.leaf_alloc_), internal_alloc_(other.internal_alloc_),
+             key_alloc_(other.key_alloc_), size_(0), comp_(std::move(other.comp_)),
+             root_(nullptr), first_(nullptr), last_(nullptr) {
+            _steal(other);
+        }
+
+        ~btree_map() {
+            clear();
+        }
+
+        btree_map& operator=(const btree_map& other) {
+            if (&other == this) return *this;
+            clear();
+            comp_ = other.comp_;
+            try {
+                _copy_from(other);
+            }
+            catch (...) {
+                root_ = first_ = last_ = nullptr;
+                throw;
+            }
+            return *this;
+        }
+
+        // 分配器相同或随移动传播时只接管指针；否则只能逐个移动元素，可能抛出异常
+        btree_map& operator=(btree_map&& other)
+            noexcept((alloc_traits::propagate_on_container_move_assignment::value || alloc_traits::is_always_equal::value) &&
+                     std::is_nothrow_move_assignable<Compare>::value) {
+            if (&other == this) return *this;
+            clear();
+            comp_ = std::move(other.comp_);
+            if (alloc_traits::propagate_on_container_move_assignment::value || alloc_ == other.alloc_) {
+                if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+                    alloc_ = other.alloc_;
+                    leaf_alloc_ = other.leaf_alloc_;
+                    internal_alloc_ = other.internal_alloc_;
+                    key_alloc_ = other.key_alloc_;
+                }
+                _steal(other);
+            }
+            else {  // 分配器不同，只能逐个移动
+                for (iterator it = other.begin(); it != other.end(); ++it) insert(std::move(*it));
+                other.clear();
+            }
+            return *this;
+        }
+
+        T& at(const Key& key) {
+            Leaf* leaf;
+            size_type index;
+            if (_locate(key, leaf, index)) return leaf->values()[index].second;
+            throw sjtu::index_out_of_bound();
+        }
+
+        const T& at(const Key& key) const {
+            Leaf* leaf;
+            size_type index;
+            if (_locate(key, leaf, index)) return leaf->values()[index].second;
+            throw sjtu::index_out_of_bound();
+        }
+
+        // Compare 声明了 is_transparent（如 std::less<>）时，可以直接用能和Key比较的类型查找，不构造临时的Key
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        T& at(const K& key) {
+            Leaf* leaf;
+            size_type index;
+            if (_locate(key, leaf, index)) return leaf->values()[index].second;
+            throw sjtu::index_out_of_bound();
+        }
+
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        const T& at(const K& key) const {
+            Leaf* leaf;
+            size_type index;
+            if (_locate(key, leaf, index)) return leaf->values()[index].second;
+            throw sjtu::index_out_of_bound();
+        }
+
+        T& operator[](const Key& key) {
+            Leaf* leaf;
+            size_type index;
+            if (_locate(key, leaf, index)) return leaf->values()[index].second;
+            return _insert(leaf, index, value_type(key, T()))->second;
+        }
+
+        const T& operator[](const Key& key) const {
+            return at(key);
+        }
+
+        allocator_type get_allocator() const { return alloc_; }
+
+        //迭代器相关操作
+        iterator begin() { return iterator(this, first_, 0); }
+        const_iterator begin() const { return const_iterator(this, first_, 0); }
+        const_iterator cbegin() const { return const_iterator(this, first_, 0); }
+        iterator end() { return iterator(this, nullptr, 0); }
+        const_iterator end() const { return const_iterator(this, nullptr, 0); }
+        const_iterator cend() const { return const_iterator(this, nullptr, 0); }
+
+        bool empty() const { return size_ == 0; }
+
+        size_t size() const { return size_; }
+
+        void clear() {
+            if (root_) _delete_subtree(root_);
+            root_ = first_ = last_ = nullptr;
+            size_ = 0;
+        }
+
+        pair<iterator, bool> insert(const value_type& value) {
+            Leaf* leaf;
+            size_type index;
+            if (_locate(value.first, leaf, index)) return pair<iterator, bool>(iterator(this, leaf, index), false);
+            return pair<iterator, bool>(_insert(leaf, index, value), true);
+        }
+
+        pair<iterator, bool> insert(value_type&& value) {
+            Leaf* leaf;
+            size_type index;
+            if (_locate(value.first, leaf, index)) return pair<iterator, bool>(iterator(this, leaf, index), false);
+            return pair<iterator, bool>(_insert(leaf, index, std::move(value)), true);
+        }
+
+        void erase(iterator pos) {
+            if (pos.leaf_ == nullptr || pos.index_ >= pos.leaf_->count) throw sjtu::invalid_iterator();
+            SJTU_CHECK_ITERATOR(pos.tree_ != this);
+            _erase(pos.leaf_, pos.index_);
+        }
+
+        size_t count(const Key& key) const {
+            Leaf* leaf;
+            size_type index;
+            return _locate(key, leaf, index) ? 1 : 0;
+        }
+
+        iterator find(const Key& key) {
+            Leaf* leaf;
+            size_type index;
+            if (_locate(key, leaf, index)) return iterator(this, leaf, index);
+            return end();
+        }
+
+        const_iterator find(const Key& key) const {
+            Leaf* leaf;
+            size_type index;
+            if (_locate(key, leaf, index)) return const_iterator(this, leaf, index);
+            return cend();
+        }
+
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        size_t count(const K& key) const {
+            Leaf* leaf;
+            size_type index;
+            return _locate(key, leaf, index) ? 1 : 0;
+        }
+
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        iterator find(const K& key) {
+            Leaf* leaf;
+            size_type index;
+            if (_locate(key, leaf, index)) return iterator(this, leaf, index);
+            return end();
+        }
+
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        const_iterator find(const K& key) const {
+            Leaf* leaf;
+            size_type index;
+            if (_locate(key, leaf, index)) return const_iterator(this, leaf, index);
+            return cend();
+        }
+    };
+
+}
+
+#endif //SJTU_BTREE_MAP_HPP
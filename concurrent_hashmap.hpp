@@ -0,0 +1,193 @@
+#ifndef SJTU_CONCURRENT_HASHMAP_HPP
+#define SJTU_CONCURRENT_HASHMAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "linked_hashmap.hpp"
+
+namespace sjtu {
+
+inline namespace SJTU_LAYOUT_NAMESPACE {
+
+// 多线程共享的哈希表：按键的哈希分成 Shards 个分片，每个分片是一个 linked_hashmap 加一把读写锁
+// 不同分片的操作互不阻塞，同一分片的读操作可以并发；每个分片内保持插入顺序
+// 元素的引用不能安全地交给调用方，所以查找按值返回，修改通过回调在锁内完成
+// Shards 必须是2的幂；分片用打散后哈希的高半部分选择，分片内的桶用低位，两者互不相关
+// 传入分配器时，每个分片用 select_on_container_copy_construction(alloc) 得到自己的分配器，只在本分片的锁下使用；
+// 这样得到的分配器之间如果仍共享状态（而不是像 pool_allocator 那样各自一组池），那份状态必须是线程安全的
+template<class Key, class T, class Hash = std::hash<Key>, class Equal = std::equal_to<Key>,
+		 class Allocator = std::allocator<pair<Key, T>>, size_t Shards = 64>
+class concurrent_hashmap {
+	static_assert(Shards != 0 && (Shards & (Shards - 1)) == 0, "Shards must be a power of two");
+
+public:
+	using value_type = pair<Key, T>;
+	using size_type = unsigned long long;
+	using allocator_type = Allocator;
+	using map_type = linked_hashmap<Key, T, Hash, Equal, Allocator>;
+
+private:
+	// 每个分片独占缓存行，相邻分片的锁不会互相干扰
+	struct alignas(64) Shard {
+		mutable std::shared_mutex mutex;
+		map_type map;
+
+		Shard() = default;
+		// 每个分片像拷贝构造容器一样从 alloc 得到自己的分配器，pool_allocator 因此每个分片一组池
+		explicit Shard(const Allocator& alloc)
+			:map(std::allocator_traits<Allocator>::select_on_container_copy_construction(alloc)) { }
+	};
+
+	Shard shards_[Shards];
+	Hash hash;
+
+	// 哈希值只算一次：用它选分片，再原样交给分片内的 linked_hashmap
+	Shard& _shard(size_t h) {
+		return shards_[(detail::mix_hash(h) >> (sizeof(size_t) * 4)) & (Shards - 1)];
+	}
+
+	const Shard& _shard(size_t h) const {
+		return shards_[(detail::mix_hash(h) >> (sizeof(size_t) * 4)) & (Shards - 1)];
+	}
+
+	// 每个分片的 map 直接用 alloc 构造；先默认构造再移动赋值时，不随移动传播的分配器会被丢掉
+	template<size_t... I>
+	concurrent_hashmap(const Allocator& alloc, std::index_sequence<I...>) :shards_{ (void(I), Shard(alloc))... } { }
+
+public:
+	concurrent_hashmap() = default;
+
+	explicit concurrent_hashmap(const Allocator& alloc) :concurrent_hashmap(alloc, std::make_index_sequence<Shards>()) { }
+
+	concurrent_hashmap(const concurrent_hashmap&) = delete;
+	concurrent_hashmap& operator=(const concurrent_hashmap&) = delete;
+
+	// 键不存在时插入，返回是否插入
+	bool insert(const value_type& value) {
+		size_t h = hash(value.first);
+		Shard& shard = _shard(h);
+		std::unique_lock<std::shared_mutex> lock(shard.mutex);
+		return shard.map._insert_hashed(value, h).second;
+	}
+
+	bool insert(value_type&& value) {
+		size_t h = hash(value.first);
+		Shard& shard = _shard(h);
+		std::unique_lock<std::shared_mutex> lock(shard.mutex);
+		return shard.map._insert_hashed(std::move(value), h).second;
+	}
+
+	// 键存在时覆盖，返回是否新插入
+	bool insert_or_assign(const Key& key, const T& value) {
+		size_t h = hash(key);
+		Shard& shard = _shard(h);
+		std::unique_lock<std::shared_mutex> lock(shard.mutex);
+		typename map_type::iterator pos = shard.map._find_hashed(key, h);
+		if (pos != shard.map.end()) {
+			pos->second = value;
+			return false;
+		}
+		shard.map._insert_hashed(value_type(key, value), h);
+		return true;
+	}
+
+	// 找到时把值拷贝到out，返回是否找到
+	bool find(const Key& key, T& out) const {
+		size_t h = hash(key);
+		const Shard& shard = _shard(h);
+		std::shared_lock<std::shared_mutex> lock(shard.mutex);
+		typename map_type::const_iterator pos = shard.map._find_hashed(key, h);
+		if (pos == shard.map.cend()) return false;
+		out = pos->second;
+		return true;
+	}
+
+	T at(const Key& key) const {
+		size_t h = hash(key);
+		const Shard& shard = _shard(h);
+		std::shared_lock<std::shared_mutex> lock(shard.mutex);
+		typename map_type::const_iterator pos = shard.map._find_hashed(key, h);
+		if (pos == shard.map.cend()) throw index_out_of_bound();
+		return pos->second;
+	}
+
+	size_t count(const Key& key) const {
+		size_t h = hash(key);
+		const Shard& shard = _shard(h);
+		std::shared_lock<std::shared_mutex> lock(shard.mutex);
+		return shard.map._find_hashed(key, h) != shard.map.cend() ? 1 : 0;
+	}
+
+	// 键存在时在写锁内调用 f(value)，返回是否找到；f 里不能再访问这个 concurrent_hashmap
+	template<class F>
+	bool update(const Key& key, F f) {
+		size_t h = hash(key);
+		Shard& shard = _shard(h);
+		std::unique_lock<std::shared_mutex> lock(shard.mutex);
+		typename map_type::iterator pos = shard.map._find_hashed(key, h);
+		if (pos == shard.map.end()) return false;
+		f(pos->second);
+		return true;
+	}
+
+	bool erase(const Key& key) {
+		size_t h = hash(key);
+		Shard& shard = _shard(h);
+		std::unique_lock<std::shared_mutex> lock(shard.mutex);
+		typename map_type::iterator pos = shard.map._find_hashed(key, h);
+		if (pos == shard.map.end()) return false;
+		shard.map.erase(pos);
+		return true;
+	}
+
+	// 逐个分片在读锁内调用 f(key, value)，分片内按插入顺序；不同分片之间不是同一时刻的快照
+	template<class F>
+	void for_each(F f) const {
+		for (const Shard& shard : shards_) {
+			std::shared_lock<std::shared_mutex> lock(shard.mutex);
+			for (typename map_type::const_iterator it = shard.map.cbegin(); it != shard.map.cend(); ++it)
+				f(it->first, it->second);
+		}
+	}
+
+	// 有其他线程同时修改时只是一个近似值
+	size_t size() const {
+		size_t n = 0;
+		for (const Shard& shard : shards_) {
+			std::shared_lock<std::shared_mutex> lock(shard.mutex);
+			n += shard.map.size();
+		}
+		return n;
+	}
+
+	bool empty() const { return size() == 0; }
+
+	void clear() {
+		for (Shard& shard : shards_) {
+			std::unique_lock<std::shared_mutex> lock(shard.mutex);
+			shard.map.clear();
+		}
+	}
+
+	// 按均匀分布给每个分片预留空间
+	void reserve(size_type n) {
+		for (Shard& shard : shards_) {
+			std::unique_lock<std::shared_mutex> lock(shard.mutex);
+			shard.map.reserve(n / Shards + 1);
+		}
+	}
+
+	static constexpr size_t shard_count() { return Shards; }
+};
+
+}  // inline namespace SJTU_LAYOUT_NAMESPACE
+
+}
+
+#endif //SJTU_CONCURRENT_HASHMAP_HPP
@@ -0,0 +1,71 @@
+#ifndef SJTU_CONFIG_HPP
+#define SJTU_CONFIG_HPP
+
+/*
+ * SJTU_CHECKED_ITERATORS 迭代器检查模式
+ *   1：list / map / linked_hashmap 的节点保存所属容器的指针，
+ *      迭代器 ++ / -- / 解引用 以及 insert / erase 会检查迭代器是否合法，不合法时抛 invalid_iterator
+ *   0：节点不保存所属容器指针（每个节点省 8 字节），迭代器不做检查，遍历时不再多一次依赖访存
+ * 没有指定时跟随 NDEBUG：调试构建检查，发布构建不检查
+ * 两种模式的节点布局不同，容器类型分别放在内联命名空间 checked_layout / unchecked_layout 里：
+ * 设置不同的编译单元之间传递容器（函数参数、全局变量等）时链接失败，而不是悄悄地按错误的布局读写内存
+ */
+#ifndef SJTU_CHECKED_ITERATORS
+#ifdef NDEBUG
+#define SJTU_CHECKED_ITERATORS 0
+#else
+#define SJTU_CHECKED_ITERATORS 1
+#endif
+#endif
+
+#if SJTU_CHECKED_ITERATORS
+#define SJTU_LAYOUT_NAMESPACE checked_layout
+#else
+#define SJTU_LAYOUT_NAMESPACE unchecked_layout
+#endif
+
+#if SJTU_CHECKED_ITERATORS
+#define SJTU_CHECK_ITERATOR(cond) do { if (cond) throw sjtu::invalid_iterator(); } while (0)
+#else
+#define SJTU_CHECK_ITERATOR(cond) ((void)0)
+#endif
+
+/*
+ * SJTU_CHECKED_SUBSCRIPT vector::operator[] 是否做越界检查
+ *   0（默认）：不检查，和 std::vector 一样，循环可以被编译器向量化；需要检查时用 at()
+ *   1：越界时抛 index_out_of_bound
+ */
+#ifndef SJTU_CHECKED_SUBSCRIPT
+#define SJTU_CHECKED_SUBSCRIPT 0
+#endif
+
+/*
+ * SJTU_HASH_SIMD flat_hashmap 查找时是否用 SIMD 指令比较控制字节
+ *   1（默认）：编译目标支持 SSE2 时用一条指令比较一组16个，否则退回不依赖指令集的实现
+ *   0：总是用不依赖指令集的实现（两个64位整数）
+ * 组宽固定为16，只影响比较的方式，不影响表的布局，不同设置的编译单元可以共用同一个 flat_hashmap
+ */
+#ifndef SJTU_HASH_SIMD
+#define SJTU_HASH_SIMD 1
+#endif
+
+namespace sjtu {
+
+namespace detail {
+
+    // 节点中的所属容器指针，只在检查模式下存在；不检查时是空基类，不占空间
+    template<class Container>
+    struct node_owner {
+#if SJTU_CHECKED_ITERATORS
+        Container* id;
+        node_owner(Container* i = nullptr) :id(i) { }
+#else
+        node_owner(Container* = nullptr) { }
+#endif
+    };
+
+}
+
+}
+
+#endif //SJTU_CONFIG_HPP
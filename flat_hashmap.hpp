@@ -0,0 +1,589 @@
+#ifndef SJTU_FLAT_HASHMAP_HPP
+#define SJTU_FLAT_HASHMAP_HPP
+
+// only for std::equal_to<T> and std::hash<T>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "config.hpp"
+#include "vector.hpp"
+#include "hash_policy.hpp"
+
+#if SJTU_HASH_SIMD && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#endif
+
+namespace sjtu {
+
+namespace detail {
+
+	// 控制字节：0~127 表示槽位被占用，值为哈希的低7位(h2)；负数表示空位或已删除
+	using ctrl_t = signed char;
+	constexpr ctrl_t ctrl_empty = -128;   // 0b10000000
+	constexpr ctrl_t ctrl_deleted = -2;   // 0b11111110
+
+	inline unsigned count_trailing_zeros(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+		return static_cast<unsigned>(__builtin_ctzll(x));
+#else
+		unsigned n = 0;
+		while ((x & 1) == 0) { x >>= 1; ++n; }
+		return n;
+#endif
+	}
+
+	// 控制字节按 group_width 个一组，探测以组为单位；组宽固定，和用不用SIMD无关，
+	// 所以不同编译选项（-msse2、-mavx2、SJTU_HASH_SIMD=0 ...）的编译单元得到的表布局和探测顺序都相同，可以混用
+	inline constexpr size_t group_width = 16;
+
+	// 一组槽位的匹配结果，第i位对应组内第i个槽位，从低位到高位依次取出
+	class group_bitmask {
+	private:
+		std::uint32_t mask_;
+	public:
+		explicit group_bitmask(std::uint32_t mask) :mask_(mask) { }
+		explicit operator bool() const { return mask_ != 0; }
+		unsigned lowest() const { return count_trailing_zeros(mask_); }
+		void pop() { mask_ &= mask_ - 1; }
+	};
+
+	// 不依赖指令集的实现：把16个控制字节装进两个64位整数一起比较
+	class group_portable {
+	private:
+		static constexpr std::uint64_t lsbs = 0x0101010101010101ull;
+		static constexpr std::uint64_t msbs = 0x8080808080808080ull;
+		std::uint64_t lo_ = 0, hi_ = 0;
+
+		// 只有每个字节最高位可能为1时，把这8位收集到结果的低8位
+		static std::uint32_t _pack(std::uint64_t x) {
+			return static_cast<std::uint32_t>(((x >> 7) * 0x0102040810204080ull) >> 56);
+		}
+
+		static group_bitmask _mask(std::uint64_t lo, std::uint64_t hi) {
+			return group_bitmask(_pack(lo) | _pack(hi) << 8);
+		}
+
+		static std::uint64_t _match(std::uint64_t word, ctrl_t h2) {
+			std::uint64_t x = word ^ (lsbs * static_cast<unsigned char>(h2));
+			return (x - lsbs) & ~x & msbs;
+		}
+
+		static std::uint64_t _match_empty(std::uint64_t word) {
+			return word & ~(word << 6) & msbs;
+		}
+
+	public:
+		using mask = group_bitmask;
+
+		// 第i个控制字节放在第i个字节上（小端机器上就是直接读出来）
+		explicit group_portable(const ctrl_t* pos) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+			std::memcpy(&lo_, pos, 8);
+			std::memcpy(&hi_, pos + 8, 8);
+#else
+			for (size_t i = 0; i != 8; ++i) {
+				lo_ |= std::uint64_t(static_cast<unsigned char>(pos[i])) << (8 * i);
+				hi_ |= std::uint64_t(static_cast<unsigned char>(pos[i + 8])) << (8 * i);
+			}
+#endif
+		}
+
+		// 可能把 h2^1 误报成匹配（借位造成），误报只会落在被占用的槽位上，调用方还要比较键
+		mask match(ctrl_t h2) const { return _mask(_match(lo_, h2), _match(hi_, h2)); }
+
+		mask match_empty() const { return _mask(_match_empty(lo_), _match_empty(hi_)); }
+
+		mask match_empty_or_deleted() const { return _mask(lo_ & msbs, hi_ & msbs); }
+	};
+
+#if SJTU_HASH_SIMD && (defined(__SSE2__) || defined(_M_X64))
+	// SSE2：一条指令比较一组16个控制字节，每个槽位对应结果的1位
+	// 组宽固定为16，AVX2也没有更宽的比较可用，支持AVX2的目标同样用这个实现
+	class group_sse2 {
+	private:
+		__m128i ctrl_;
+	public:
+		using mask = group_bitmask;
+
+		explicit group_sse2(const ctrl_t* pos) :ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) { }
+
+		mask match(ctrl_t h2) const {
+			return mask(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8(h2)))));
+		}
+
+		mask match_empty() const {
+			return mask(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8(ctrl_empty)))));
+		}
+
+		// 空位和已删除的控制字节都是负数，直接取符号位
+		mask match_empty_or_deleted() const {
+			return mask(static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl_)));
+		}
+	};
+#endif
+
+	// 编译时按可用的指令集选择比较一组控制字节的实现，只影响速度，不影响表的布局
+#if SJTU_HASH_SIMD && (defined(__SSE2__) || defined(_M_X64))
+	using group = group_sse2;
+#else
+	using group = group_portable;
+#endif
+
+}
+
+// 开放寻址的哈希表，接口和 linked_hashmap 相同，遍历顺序同样是插入顺序
+// 元素按插入顺序紧凑地存放在 entries_ 中；另有一张控制字节表 ctrl_，每个槽位一个字节，
+// 存哈希的低7位，查找时一次比较一组槽位的控制字节，只有h2相同的槽位才去比较键
+// 槽位按组对齐，探测以组为单位，遇到含空位的组即可停止
+// erase 在 entries_ 中留下空洞，rehash时压缩；插入可能触发rehash，使迭代器和引用失效
+template<class Key, class T, class Hash = std::hash<Key>, class Equal = std::equal_to<Key>,
+		 class Allocator = std::allocator<pair<Key, T>>>
+class flat_hashmap {
+public:
+	using value_type = pair<Key, T>;
+	using size_type = unsigned long long;
+	using allocator_type = Allocator;
+
+	class const_iterator;
+	class iterator {
+		friend class flat_hashmap;
+	private:
+		flat_hashmap* map_;
+		size_type index_;
+	public:
+		iterator() = default;
+		iterator(flat_hashmap* map, size_type index) :map_(map), index_(index) { }
+		iterator(const iterator& other) :map_(other.map_), index_(other.index_) { }
+
+		value_type& operator*() const { return map_->entries_[index_]; }
+		value_type* operator->() const { return map_->entries_ + index_; }
+
+		iterator& operator++() {
+			SJTU_CHECK_ITERATOR(map_ == nullptr || index_ >= map_->used_);
+			index_ = map_->_next(index_);
+			return *this;
+		}
+
+		iterator operator++(int) {
+			iterator temp = *this;
+			++*this;
+			return temp;
+		}
+
+		iterator& operator--() {
+			SJTU_CHECK_ITERATOR(map_ == nullptr || map_->_prev(index_) == npos);
+			index_ = map_->_prev(index_);
+			return *this;
+		}
+
+		iterator operator--(int) {
+			iterator temp = *this;
+			--*this;
+			return temp;
+		}
+
+		bool operator==(const iterator &rhs) const { return map_ == rhs.map_ && index_ == rhs.index_; }
+		bool operator==(const const_iterator &rhs) const { return map_ == rhs.map_ && index_ == rhs.index_; }
+		bool operator!=(const iterator &rhs) const { return !(*this == rhs); }
+		bool operator!=(const const_iterator &rhs) const { return !(*this == rhs); }
+	};
+
+	class const_iterator {
+		friend class flat_hashmap;
+	private:
+		const flat_hashmap* map_;
+		size_type index_;
+	public:
+		const_iterator() = default;
+		const_iterator(const flat_hashmap* map, size_type index) :map_(map), index_(index) { }
+		const_iterator(const iterator& other) :map_(other.map_), index_(other.index_) { }
+		const_iterator(const const_iterator& other) :map_(other.map_), index_(other.index_) { }
+
+		const value_type& operator*() const { return map_->entries_[index_]; }
+		const value_type* operator->() const { return map_->entries_ + index_; }
+
+		const_iterator& operator++() {
+			SJTU_CHECK_ITERATOR(map_ == nullptr || index_ >= map_->used_);
+			index_ = map_->_next(index_);
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const_iterator temp = *this;
+			++*this;
+			return temp;
+		}
+
+		const_iterator& operator--() {
+			SJTU_CHECK_ITERATOR(map_ == nullptr || map_->_prev(index_) == npos);
+			index_ = map_->_prev(index_);
+			return *this;
+		}
+
+		const_iterator operator--(int) {
+			const_iterator temp = *this;
+			--*this;
+			return temp;
+		}
+
+		bool operator==(const iterator &rhs) const { return map_ == rhs.map_ && index_ == rhs.index_; }
+		bool operator==(const const_iterator &rhs) const { return map_ == rhs.map_ && index_ == rhs.index_; }
+		bool operator!=(const iterator &rhs) const { return !(*this == rhs); }
+		bool operator!=(const const_iterator &rhs) const { return !(*this == rhs); }
+	};
+
+private:
+	using alloc_traits = std::allocator_traits<Allocator>;
+	template<class U>
+	using rebind_alloc = typename alloc_traits::template rebind_alloc<U>;
+	using ctrl_table = vector<detail::ctrl_t, rebind_alloc<detail::ctrl_t>>;
+	using index_table = vector<size_type, rebind_alloc<size_type>>;
+	using group = detail::group;
+
+	static constexpr size_type npos = size_type(-1);
+	static constexpr size_type min_capacity = detail::group_width;
+
+	Allocator alloc_;
+	value_type* entries_;  // 按插入顺序存放元素，erase留下的空洞在rehash时压缩
+	index_table where_;    // where_[i]：entries_[i] 所在的槽位，空洞为npos
+	size_type used_;       // entries_ 用到的位置（含空洞），不小于被占用和已删除的槽位数
+	size_type size_;
+	ctrl_table ctrl_;      // 每个槽位的控制字节，槽位数是2的幂且是组宽的倍数；没插入过元素时为空
+	index_table slots_;    // slots_[s]：槽位s中元素在 entries_ 中的下标
+	Hash hash;
+	Equal equal;
+
+	static detail::ctrl_t _h2(size_t h) { return static_cast<detail::ctrl_t>(h & 0x7f); }
+
+	template<class K>
+	size_t _hash(const K& key) const { return detail::mix_hash(hash(key)); }
+
+	// entries_ 的容量，也是允许占用的槽位数（含已删除），负载因子 7/8
+	static size_type _entry_capacity(size_type capacity) { return capacity - capacity / 8; }
+
+	// 按组探测：组号依次为 g, g+1, g+3, g+6 ...（三角数步长），组数是2的幂时能走遍所有组
+	// 返回第一个空位或已删除的槽位；负载因子不超过7/8，一定能找到
+	static size_type _find_free_slot(const ctrl_table& ctrl, size_t h) {
+		size_type gmask = ctrl.size() / detail::group_width - 1;
+		size_type g = (h >> 7) & gmask;
+		for (size_type step = 1; ; ++step) {
+			auto m = group(ctrl.data() + g * detail::group_width).match_empty_or_deleted();
+			if (m) return g * detail::group_width + m.lowest();
+			g = (g + step) & gmask;
+		}
+	}
+
+	template<class K>
+	size_type _find(const K& key) const {
+		if (size_ == 0) return npos;
+		size_t h = _hash(key);
+		size_type gmask = ctrl_.size() / detail::group_width - 1;
+		size_type g = (h >> 7) & gmask;
+		for (size_type step = 1; ; ++step) {
+			group grp(ctrl_.data() + g * detail::group_width);
+			for (auto m = grp.match(_h2(h)); m; m.pop()) {
+				size_type index = slots_[g * detail::group_width + m.lowest()];
+				if (equal(entries_[index].first, key)) return index;
+			}
+			if (grp.match_empty()) return npos;
+			g = (g + step) & gmask;
+		}
+	}
+
+	size_type _next(size_type index) const {
+		++index;
+		while (index < used_ && where_[index] == npos) ++index;
+		return index;
+	}
+
+	size_type _prev(size_type index) const {
+		while (index != 0) {
+			--index;
+			if (where_[index] != npos) return index;
+		}
+		return npos;
+	}
+
+	size_type _first() const {
+		return used_ != 0 && where_[0] == npos ? _next(0) : 0;
+	}
+
+	// 换成 capacity 个槽位并压缩空洞；先建好新的控制字节表再搬元素，哈希抛异常时原表不变
+	void _rehash(size_type capacity) {
+		size_type entry_capacity = _entry_capacity(capacity);
+		ctrl_table new_ctrl(capacity, detail::ctrl_empty, ctrl_.get_allocator());
+		index_table new_slots(capacity, 0, slots_.get_allocator());
+		index_table new_where(entry_capacity, npos, where_.get_allocator());
+		size_type n = 0;
+		for (size_type i = 0; i != used_; ++i) {
+			if (where_[i] == npos) continue;
+			size_t h = _hash(entries_[i].first);
+			size_type slot = _find_free_slot(new_ctrl, h);
+			new_ctrl[slot] = _h2(h);
+			new_slots[slot] = n;
+			new_where[n++] = slot;
+		}
+
+		value_type* new_entries = alloc_traits::allocate(alloc_, entry_capacity);
+		n = 0;
+		try {
+			for (size_type i = 0; i != used_; ++i) {
+				if (where_[i] == npos) continue;
+				alloc_traits::construct(alloc_, new_entries + n, std::move_if_noexcept(entries_[i]));
+				++n;
+			}
+		}
+		catch (...) {
+			while (n != 0) alloc_traits::destroy(alloc_, new_entries + --n);
+			alloc_traits::deallocate(alloc_, new_entries, entry_capacity);
+			throw;
+		}
+
+		_release_entries();
+		entries_ = new_entries;
+		used_ = size_;
+		ctrl_ = std::move(new_ctrl);
+		slots_ = std::move(new_slots);
+		where_ = std::move(new_where);
+	}
+
+	// 析构所有元素并释放 entries_，控制字节表不动
+	void _release_entries() {
+		for (size_type i = 0; i != used_; ++i)
+			if (where_[i] != npos) alloc_traits::destroy(alloc_, entries_ + i);
+		if (entries_) alloc_traits::deallocate(alloc_, entries_, _entry_capacity(ctrl_.size()));
+		entries_ = nullptr;
+	}
+
+	// 已知key不存在，放入新元素
+	size_type _insert(value_type value) {
+		if (ctrl_.empty()) _rehash(min_capacity);
+		else if (used_ == _entry_capacity(ctrl_.size())) {
+			// 空洞多于一半时原地压缩，否则扩容
+			_rehash(size_ <= used_ / 2 ? ctrl_.size() : ctrl_.size() * 2);
+		}
+		size_t h = _hash(value.first);
+		size_type slot = _find_free_slot(ctrl_, h);
+		alloc_traits::construct(alloc_, entries_ + used_, std::move(value));
+		ctrl_[slot] = _h2(h);
+		slots_[slot] = used_;
+		where_[used_] = slot;
+		++size_;
+		return used_++;
+	}
+
+	void _erase(size_type index) {
+		size_type slot = where_[index];
+		// 本组还有空位说明从没有探测越过这一组，可以直接标成空位，否则只能标成已删除
+		group grp(ctrl_.data() + slot / detail::group_width * detail::group_width);
+		ctrl_[slot] = grp.match_empty() ? detail::ctrl_empty : detail::ctrl_deleted;
+		where_[index] = npos;
+		alloc_traits::destroy(alloc_, entries_ + index);
+		--size_;
+	}
+
+	// 释放所有元素和表，回到刚构造时的状态
+	void _clear() {
+		_release_entries();
+		used_ = size_ = 0;
+		ctrl_ = ctrl_table(ctrl_.get_allocator());
+		slots_ = index_table(slots_.get_allocator());
+		where_ = index_table(where_.get_allocator());
+	}
+
+	void _copy(const flat_hashmap& other) {
+		if (other.empty()) return;
+		_rehash(other.ctrl_.size());
+		for (const_iterator it = other.begin(); it != other.end(); ++it) _insert(*it);
+	}
+
+	// 接管other的元素和表，调用前自己必须是空的
+	void _steal(flat_hashmap& other) {
+		entries_ = other.entries_;
+		used_ = other.used_;
+		size_ = other.size_;
+		ctrl_ = std::move(other.ctrl_);
+		slots_ = std::move(other.slots_);
+		where_ = std::move(other.where_);
+		other.entries_ = nullptr;
+		other.used_ = other.size_ = 0;
+	}
+
+public:
+	// 空的flat_hashmap不分配内存，第一次插入时才分配
+	flat_hashmap() :flat_hashmap(Allocator()) { }
+
+	explicit flat_hashmap(const Allocator& alloc)
+		:alloc_(alloc), entries_(nullptr), where_(alloc), used_(0), size_(0), ctrl_(alloc), slots_(alloc) { }
+
+	flat_hashmap(const flat_hashmap &other)
+		:alloc_(alloc_traits::select_on_container_copy_construction(other.alloc_)), entries_(nullptr), where_(alloc_),
+		 used_(0), size_(0), ctrl_(alloc_), slots_(alloc_), hash(other.hash), equal(other.equal) {
+		try {
+			_copy(other);
+		}
+		catch (...) {
+			_clear();
+			throw;
+		}
+	}
+
+	// 只交换指针，不分配内存；放在vector等容器里扩容时会移动而不是逐个拷贝
+	flat_hashmap(flat_hashmap &&other)
+		noexcept(std::is_nothrow_move_constructible<Hash>::value && std::is_nothrow_move_constructible<Equal>::value)
+		:alloc_(other.alloc_), entries_(nullptr), where_(other.where_.get_allocator()), used_(0), size_(0),
+		 ctrl_(other.ctrl_.get_allocator()), slots_(other.slots_.get_allocator()),
+		 hash(std::move(other.hash)), equal(std::move(other.equal)) {
+		_steal(other);
+	}
+
+	flat_hashmap & operator=(const flat_hashmap &other) {
+		if (&other == this) return *this;
+		_clear();
+		// 和拷贝构造一样连同Hash、Equal一起拷贝，_copy要用拷贝来的Hash重新计算哈希
+		hash = other.hash;
+		equal = other.equal;
+		_copy(other);
+		return *this;
+	}
+
+	// 分配器相同或随移动传播时只交换指针；否则只能逐个移动元素，可能抛出异常
+	flat_hashmap & operator=(flat_hashmap &&other)
+		noexcept((alloc_traits::propagate_on_container_move_assignment::value || alloc_traits::is_always_equal::value) &&
+				 std::is_nothrow_move_assignable<Hash>::value && std::is_nothrow_move_assignable<Equal>::value) {
+		if (&other == this) return *this;
+		_clear();
+		if (alloc_traits::propagate_on_container_move_assignment::value || alloc_ == other.alloc_) {
+			if constexpr (alloc_traits::propagate_on_container_move_assignment::value) alloc_ = other.alloc_;
+			_steal(other);
+		}
+		else {  // 分配器不同，不能接管对方的内存，只能逐个移动
+			for (iterator it = other.begin(); it != other.end(); ++it) _insert(std::move(*it));
+			other._clear();
+		}
+		hash = std::move(other.hash);
+		equal = std::move(other.equal);
+		return *this;
+	}
+
+	~flat_hashmap() {
+		_clear();
+	}
+
+	T & at(const Key &key) {
+		size_type index = _find(key);
+		if (index != npos) return entries_[index].second;
+		throw index_out_of_bound();
+	}
+
+	const T & at(const Key &key) const {
+		size_type index = _find(key);
+		if (index != npos) return entries_[index].second;
+		throw index_out_of_bound();
+	}
+
+	T & operator[](const Key &key) {
+		size_type index = _find(key);
+		if (index == npos) index = _insert(value_type(key, T()));
+		return entries_[index].second;
+	}
+
+	const T & operator[](const Key &key) const {
+		return at(key);
+	}
+
+	allocator_type get_allocator() const { return alloc_; }
+
+	// 迭代器相关操作
+	iterator begin() {
+		return iterator(this, _first());
+	}
+	const_iterator begin() const {
+		return const_iterator(this, _first());
+	}
+	iterator end() {
+		return iterator(this, used_);
+	}
+	const_iterator end() const {
+		return const_iterator(this, used_);
+	}
+	const_iterator cbegin() const {
+		return begin();
+	}
+	const_iterator cend() const {
+		return end();
+	}
+
+	bool empty() const { return size_ == 0; }
+
+	size_t size() const { return size_; }
+
+	void clear() { _clear(); }
+
+	pair<iterator, bool> insert(const value_type &value) {
+		size_type index = _find(value.first);
+		if (index != npos) return pair<iterator, bool>(iterator(this, index), false);
+		return pair<iterator, bool>(iterator(this, _insert(value)), true);
+	}
+
+	pair<iterator, bool> insert(value_type &&value) {
+		size_type index = _find(value.first);
+		if (index != npos) return pair<iterator, bool>(iterator(this, index), false);
+		return pair<iterator, bool>(iterator(this, _insert(std::move(value))), true);
+	}
+
+	void erase(iterator pos) {
+		if (pos.map_ == nullptr || pos.index_ >= used_ || where_[pos.index_] == npos) throw invalid_iterator();
+		SJTU_CHECK_ITERATOR(pos.map_ != this);
+		_erase(pos.index_);
+	}
+
+	size_t count(const Key &key) const { return _find(key) != npos ? 1 : 0; }
+	iterator find(const Key &key) {
+		size_type index = _find(key);
+		return iterator(this, index != npos ? index : used_);
+	}
+	const_iterator find(const Key &key) const {
+		size_type index = _find(key);
+		return const_iterator(this, index != npos ? index : used_);
+	}
+
+	// Hash 和 Equal 都声明了 is_transparent 时，可以直接用能和Key比较的类型查找，不构造临时的Key
+	// 要求对相等的键，hash(k) 和 hash(key) 的结果相同
+	template<class K, class H = Hash, class E = Equal, class = detail::transparent_t<H, E>>
+	size_t count(const K &key) const { return _find(key) != npos ? 1 : 0; }
+
+	template<class K, class H = Hash, class E = Equal, class = detail::transparent_t<H, E>>
+	iterator find(const K &key) {
+		size_type index = _find(key);
+		return iterator(this, index != npos ? index : used_);
+	}
+
+	template<class K, class H = Hash, class E = Equal, class = detail::transparent_t<H, E>>
+	const_iterator find(const K &key) const {
+		size_type index = _find(key);
+		return const_iterator(this, index != npos ? index : used_);
+	}
+
+	template<class K, class H = Hash, class E = Equal, class = detail::transparent_t<H, E>>
+	T & at(const K &key) {
+		size_type index = _find(key);
+		if (index != npos) return entries_[index].second;
+		throw index_out_of_bound();
+	}
+
+	template<class K, class H = Hash, class E = Equal, class = detail::transparent_t<H, E>>
+	const T & at(const K &key) const {
+		size_type index = _find(key);
+		if (index != npos) return entries_[index].second;
+		throw index_out_of_bound();
+	}
+};
+
+}
+
+#endif //SJTU_FLAT_HASHMAP_HPP
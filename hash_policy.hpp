@@ -0,0 +1,55 @@
+#ifndef SJTU_HASH_POLICY_HPP
+#define SJTU_HASH_POLICY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace sjtu {
+
+namespace detail {
+
+    // murmur3 的 fmix64：输入的每一位都影响输出的每一位，
+    // std::hash<int> 这类恒等哈希的连续键也能均匀地落到低位和高位
+    inline size_t mix_hash(size_t h) {
+        std::uint64_t x = static_cast<std::uint64_t>(h);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+        return static_cast<size_t>(x);
+    }
+
+    // Hash 和 Equal 都声明了 is_transparent 时才有效，用来开启异构查找
+    template<class Hash, class Equal>
+    using transparent_t = std::void_t<typename Hash::is_transparent, typename Equal::is_transparent>;
+
+}
+
+// linked_hashmap 的桶策略，桶数在扩容时翻倍、缩容时减半
+//   initial：第一次插入时的桶数
+//   index(h, n)：哈希值为h的键在n个桶中的下标
+//   round(n)：不少于n的合法桶数（reserve/rehash 指定桶数时用）
+
+// 桶数是2的幂，先打散哈希再取低位，不做除法（默认）
+struct pow2_buckets {
+    static constexpr size_t initial = 16;
+    static size_t index(size_t h, size_t n) { return detail::mix_hash(h) & (n - 1); }
+    static size_t round(size_t n) {
+        size_t r = 1;
+        while (r < n) r <<= 1;
+        return r;
+    }
+};
+
+// 桶数从10开始，哈希值直接对桶数取模；哈希本身分布就很好时可以省掉打散
+struct modulo_buckets {
+    static constexpr size_t initial = 10;
+    static size_t index(size_t h, size_t n) { return h % n; }
+    static size_t round(size_t n) { return n == 0 ? 1 : n; }
+};
+
+}
+
+#endif //SJTU_HASH_POLICY_HPP
@@ -4,39 +4,55 @@
 // only for std::equal_to<T> and std::hash<T>
 #include <functional>
 #include <cstddef>
+#include <memory>
 #include "utility.hpp"
 #include "exceptions.hpp"
+#include "config.hpp"
 #include "vector.hpp"
+#include "hash_policy.hpp"
 
 namespace sjtu {
     
+inline namespace SJTU_LAYOUT_NAMESPACE {
+
+// 用预先算好的哈希值访问 linked_hashmap 的内部接口，见 _insert_hashed
+template<class Key, class T, class Hash, class Equal, class Allocator, size_t Shards>
+class concurrent_hashmap;
+
 // In linked_hashmap, iteration ordering is differ from map, which is the order in which keys were inserted into the map.
 // You should maintain a doubly-linked list running through all of its entries to keep the correct iteration order. 
 // Note that insertion order is not affected if a key is re-inserted into the map.  
+// BucketPolicy 决定桶数和键落在哪个桶，见 hash_policy.hpp
     
-template<class Key, class T, class Hash = std::hash<Key>,  class Equal = std::equal_to<Key>>
+template<class Key, class T, class Hash = std::hash<Key>,  class Equal = std::equal_to<Key>,
+		 class Allocator = std::allocator<pair<Key, T>>, class BucketPolicy = pow2_buckets>
 class linked_hashmap {
+	template<class, class, class, class, class, size_t> friend class concurrent_hashmap;
 public:
 	using value_type = pair<Key, T>;
 	using size_type = unsigned long long;
+	using allocator_type = Allocator;
  private:
-	class Node {
+	class Node : public detail::node_owner<linked_hashmap> {  // 检查模式下带所属容器指针id
 		friend class linked_hashmap;
 	private:
 		value_type kv_;
-		linked_hashmap* id;
+		size_t hash_;  // 键的完整哈希值，rehash时不必再调用Hash，查找时先比较它再调用Equal
 
 		Node* hashnext_;
+		Node** hashprev_;  // 指向桶链表中指向自己的那个指针（桶头或前一个节点的hashnext_），erase时不必扫描桶
 		Node* prev_;
 		Node* next_;
 	public:
 		Node() = default;
 
-		Node(const value_type& value, linked_hashmap* i, Node* hnext = nullptr) :
-			kv_(value), id(i), hashnext_(hnext), prev_(nullptr), next_(nullptr) { }
+		Node(const value_type& value, size_t h, linked_hashmap* i) :
+			detail::node_owner<linked_hashmap>(i), kv_(value), hash_(h),
+			hashnext_(nullptr), hashprev_(nullptr), prev_(nullptr), next_(nullptr) { }
 
-		Node(value_type&& value, linked_hashmap* i, Node* hnext = nullptr) :
-			kv_(value), id(i), hashnext_(hnext), prev_(nullptr), next_(nullptr) { }
+		Node(value_type&& value, size_t h, linked_hashmap* i) :
+			detail::node_owner<linked_hashmap>(i), kv_(std::move(value)), hash_(h),
+			hashnext_(nullptr), hashprev_(nullptr), prev_(nullptr), next_(nullptr) { }
 
 		~Node() { }
 	};
@@ -57,30 +73,26 @@ public:
         value_type* operator->() const { return &(node_->kv_); }
 
 		iterator& operator++() {
-            if (node_ == nullptr) throw sjtu::invalid_iterator();
-            if (node_ == node_->id->end_) throw sjtu::invalid_iterator();
+            SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
  			node_ = node_->next_;
             return *this;
         }
 
 		iterator operator++(int) {
-            if (node_ == nullptr) throw sjtu::invalid_iterator();
-            if (node_ == node_->id->end_) throw sjtu::invalid_iterator();
+            SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
 			iterator temp = *this;
  			node_ = node_->next_;
             return temp;
 		}
 
 		iterator & operator--() {
-            if (node_ == nullptr) throw sjtu::invalid_iterator();
-            if (node_ == node_->id->end_->next_) throw sjtu::invalid_iterator();
+            SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_->next_);
  			node_ = node_->prev_;
             return *this;
 		}
 
 		iterator operator--(int) {
-            if (node_ == nullptr) throw sjtu::invalid_iterator();
-            if (node_ == node_->id->end_->next_) throw sjtu::invalid_iterator();
+            SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_->next_);
 			iterator temp = *this;
  			node_ = node_->prev_;
             return temp;
@@ -106,30 +118,26 @@ public:
         const value_type* operator->() const { return &(node_->kv_); }
 
 		const_iterator& operator++() {
-            if (node_ == nullptr) throw sjtu::invalid_iterator();
-            if (node_ == node_->id->end_) throw sjtu::invalid_iterator();
+            SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
  			node_ = node_->next_;
             return *this;
         }
 
 		const_iterator operator++(int) {
-            if (node_ == nullptr) throw sjtu::invalid_iterator();
-            if (node_ == node_->id->end_) throw sjtu::invalid_iterator();
+            SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
 			const_iterator temp = *this;
  			node_ = node_->next_;
             return temp;
 		}
 
 		const_iterator & operator--() {
-            if (node_ == nullptr) throw sjtu::invalid_iterator();
-            if (node_ == node_->id->end_->next_) throw sjtu::invalid_iterator();
+            SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_->next_);
  			node_ = node_->prev_;
             return *this;
 		}
 
 		const_iterator operator--(int) {
-            if (node_ == nullptr) throw sjtu::invalid_iterator();
-            if (node_ == node_->id->end_->next_) throw sjtu::invalid_iterator();
+            SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_->next_);
 			const_iterator temp = *this;
  			node_ = node_->prev_;
             return temp;
@@ -142,129 +150,305 @@ public:
 	};
 	
 private:
-	Node* end_;  // 指向list的尾节点 循环双向
-	vector<Node*> table_;
+	using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+	using node_traits = std::allocator_traits<node_allocator>;
+	using table_type = vector<Node*, typename std::allocator_traits<Allocator>::template rebind_alloc<Node*>>;
+
+	node_allocator alloc_;
+	Node* end_;  // 指向list的尾节点 循环双向；没插入过元素时为nullptr
+	table_type table_;  // 没插入过元素时为空
+	table_type old_table_;  // 渐进式rehash时的旧桶数组，[0, migrate_) 的桶已经搬完；不在搬迁时为空
+	size_type migrate_;
 	size_type size_;
+	bool incremental_;  // 是否渐进式rehash
+	bool auto_shrink_;  // erase后元素过少时是否缩容
+	float max_load_factor_;
 	Hash hash;
 	Equal equal;
 
-	Node* _find(const Key& key) const {
-		size_type h_index = hash(key) % table_.size();
-		Node* pos = table_[h_index];
-		while (pos) {
-			if (equal(pos->kv_.first, key)) return pos;
-			pos = pos->hashnext_;
+	// 渐进式rehash时每次插入/删除搬迁的桶数，缩容到1/2后至少还要 n/4 次操作才会再扩容，8个足够在那之前搬完
+	static constexpr size_type rehash_step = 8;
+
+	template<class... Args>
+	Node* _new_node(Args&&... args) {
+		Node* p = node_traits::allocate(alloc_, 1);
+		try {
+			node_traits::construct(alloc_, p, std::forward<Args>(args)...);
+		}
+		catch (...) {
+			node_traits::deallocate(alloc_, p, 1);
+			throw;
+		}
+		return p;
+	}
+
+	void _delete_node(Node* p) {
+		node_traits::destroy(alloc_, p);
+		node_traits::deallocate(alloc_, p, 1);
+	}
+
+	// 哨兵节点不构造kv_，只分配内存；第一次插入时才分配
+	void _init_end() {
+		end_ = node_traits::allocate(alloc_, 1);
+		end_->next_ = end_->prev_ = end_;
+#if SJTU_CHECKED_ITERATORS
+		end_->id = this;
+#endif
+	}
+
+	// 接管other的节点，调用前自己必须是空的且没有哨兵
+	void _steal(linked_hashmap& other) {
+		end_ = other.end_;
+		table_ = std::move(other.table_);
+		old_table_ = std::move(other.old_table_);
+		migrate_ = other.migrate_;
+		size_ = other.size_;
+		other.end_ = nullptr;
+		other.migrate_ = other.size_ = 0;
+#if SJTU_CHECKED_ITERATORS
+		if (end_) {
+			end_->id = this;
+			for (Node* pos = end_->next_; pos != end_; pos = pos->next_) pos->id = this;
+		}
+#endif
+	}
+
+	static size_type _bucket(size_t h, size_type n) {
+		return BucketPolicy::index(h, n);
+	}
+
+	template<class K>
+	Node* _find_in(const table_type& table, size_type h_index, const K& key, size_t h) const {
+		for (Node* pos = table[h_index]; pos; pos = pos->hashnext_)
+			if (pos->hash_ == h && equal(pos->kv_.first, key)) return pos;
+		return nullptr;
+	}
+
+	template<class K>
+	Node* _find(const K& key, size_t h) const {
+		if (table_.empty()) return end_;
+		Node* pos = _find_in(table_, _bucket(h, table_.size()), key, h);
+		if (pos) return pos;
+		if (!old_table_.empty()) {  // 搬迁中：还没搬走的桶里也要找
+			size_type h_index = _bucket(h, old_table_.size());
+			if (h_index >= migrate_ && (pos = _find_in(old_table_, h_index, key, h))) return pos;
 		}
 		return end_;
 	}
 
-	void _doubleSize() {
-		vector<Node*> new_table(table_.size() * 2, nullptr);
-		for (iterator it = begin(); it != end(); ++it) {
-			Node* pos = it.node_;
-			size_type h_index = hash(pos->kv_.first) % (table_.size() * 2);
-			pos->hashnext_ = new_table[h_index];
-			new_table[h_index] = pos;
+	template<class K>
+	Node* _find(const K& key) const {
+		return _find(key, hash(key));
+	}
+
+	// 把node插到以head为头的桶链表最前面
+	static void _link(Node*& head, Node* node) {
+		node->hashnext_ = head;
+		if (head) head->hashprev_ = &node->hashnext_;
+		head = node;
+		node->hashprev_ = &head;
+	}
+
+	// 从桶链表中摘下node，O(1)
+	static void _unlink(Node* node) {
+		*node->hashprev_ = node->hashnext_;
+		if (node->hashnext_) node->hashnext_->hashprev_ = node->hashprev_;
+	}
+
+	// 把旧桶数组中最多count个桶搬到新桶数组，搬完后释放旧桶数组
+	void _migrate(size_type count) {
+		for (; count != 0 && migrate_ != old_table_.size(); --count, ++migrate_) {
+			Node* pos = old_table_[migrate_];
+			while (pos) {
+				Node* next = pos->hashnext_;
+				_link(table_[_bucket(pos->hash_, table_.size())], pos);
+				pos = next;
+			}
+		}
+		if (migrate_ == old_table_.size()) {
+			old_table_ = table_type(old_table_.get_allocator());
+			migrate_ = 0;
 		}
-		table_ = new_table;
 	}
 
-	void _shrinkSize() {
-		vector<Node*> new_table(table_.size() / 2, nullptr);
-		for (iterator it = begin(); it != end(); ++it) {
-			Node* pos = it.node_;
-			size_type h_index = hash(pos->kv_.first) % (table_.size() / 2);
-			pos->hashnext_ = new_table[h_index];
-			new_table[h_index] = pos;
+	// 用节点中保存的哈希值重新分桶，不调用Hash
+	// 渐进式时只换上新的桶数组，节点之后分批搬迁
+	// 桶数组用移动赋值交换，缓冲区地址不变，节点的hashprev_仍然有效
+	void _rehash(size_type n) {
+		if (!old_table_.empty()) _migrate(old_table_.size());  // 上一次还没搬完，先搬完
+		table_type new_table(n, nullptr, table_.get_allocator());
+		if (incremental_) {
+			old_table_ = std::move(table_);
+			table_ = std::move(new_table);
+			migrate_ = 0;
+			_migrate(rehash_step);
+			return;
 		}
-		table_ = new_table;
+		for (Node* pos = end_->next_; pos != end_; pos = pos->next_)
+			_link(new_table[_bucket(pos->hash_, n)], pos);
+		table_ = std::move(new_table);
 	}
 
-	Node* _insert(value_type value) {
-		if (size_ == table_.size()) _doubleSize();
-		
-		++size_;
-		size_type h_index = hash(value.first) % table_.size();
-		Node* newnode = new Node(value, this, table_[h_index]);
-		table_[h_index] = newnode;
+	// 放下count个元素而平均每桶不超过max_load_factor_个所需的桶数
+	size_type _min_buckets(size_type count) const {
+		double n = static_cast<double>(count) / max_load_factor_;
+		size_type buckets = static_cast<size_type>(n);
+		return buckets < n ? buckets + 1 : buckets;
+	}
 
-		end_->prev_->next_ = newnode;
-		newnode->prev_ = end_->prev_;
-		newnode->next_ = end_;
-		end_->prev_ = newnode;
+	// 不扩容时最多能放的元素数
+	double _max_elements() const {
+		return static_cast<double>(table_.size()) * max_load_factor_;
+	}
+
+	void _doubleSize() {
+		size_type n = _min_buckets(size_ + 1);
+		_rehash(BucketPolicy::round(n > table_.size() * 2 ? n : table_.size() * 2));
+	}
+
+	void _shrinkSize() {
+		_rehash(table_.size() / 2);
+	}
 
+	// h是value.first的哈希值，调用前已确认键不存在
+	Node* _insert(value_type value, size_t h) {
+		if (end_ == nullptr) _init_end();
+		if (table_.empty()) table_ = table_type(BucketPolicy::initial, nullptr, table_.get_allocator());
+		else if (size_ + 1 > _max_elements()) _doubleSize();
+		else if (!old_table_.empty()) _migrate(rehash_step);
+		
+		Node* newnode = _new_node(std::move(value), h, this);
+		++size_;
+		_link(table_[_bucket(h, table_.size())], newnode);
+		_link_back(newnode);
 		return newnode;
 	}
 
+	// 把node接到遍历顺序的末尾
+	void _link_back(Node* node) {
+		end_->prev_->next_ = node;
+		node->prev_ = end_->prev_;
+		node->next_ = end_;
+		end_->prev_ = node;
+	}
+
 	void _erase(Node* pos){
 		--size_;
 		pos->prev_->next_ = pos->next_;
 		pos->next_->prev_ = pos->prev_;
 
-		size_type h_index = hash(pos->kv_.first) % table_.size();
-
-		Node* cur = table_[h_index];
-		Node* pre = nullptr;
-		while (cur) {
-			if (equal(cur->kv_.first, pos->kv_.first)) {
-				if (pre == nullptr) table_[h_index] = cur->hashnext_;
-				else pre->hashnext_ = cur->hashnext_;
-				delete cur;
-				break;
-			}
-			pre = cur;
-			cur = cur->hashnext_;
-		}
-		if(size_ < table_.size() / 4) _shrinkSize();
+		_unlink(pos);  // 搬迁中时节点也可能在旧桶数组里，hashprev_都指得到
+		_delete_node(pos);
+		if (!old_table_.empty()) _migrate(rehash_step);
+		else if(auto_shrink_ && table_.size() > 1 && size_ < _max_elements() / 4) _shrinkSize();
 	}
 
+	// 释放所有节点和桶数组，哨兵保留
 	void _clear(){
 		for (iterator it = begin(); it != end(); ) {
 			Node* temp = it.node_;
 			++it;
-			delete temp;
+			_delete_node(temp);
 		}
 		size_ = 0;
-		end_->next_ = end_->prev_ = end_;
-		table_ = vector<Node*>(10, nullptr);
+		if (end_) end_->next_ = end_->prev_ = end_;
+		table_ = table_type(table_.get_allocator());
+		old_table_ = table_type(old_table_.get_allocator());
+		migrate_ = 0;
+	}
+
+	// 释放所有节点、桶数组和哨兵，回到刚构造时的状态
+	void _destroy() {
+		_clear();
+		if (end_) node_traits::deallocate(alloc_, end_, 1);
+		end_ = nullptr;
+	}
+
+	void _copy(const linked_hashmap& other) {
+		if (other.empty()) return;
+		table_ = table_type(other.table_.size(), nullptr, table_.get_allocator());
+		for (const_iterator it = other.begin(); it != other.end(); ++it) _insert(*it, it.node_->hash_);
+	}
+
+	// 带预先算好的哈希值的查找和插入，h 必须等于 hash(key)，否则元素会放进错误的桶
+	// 只给算过哈希的 concurrent_hashmap 用（它用同一个哈希值选分片），不对外公开
+	template<class V>
+	pair<iterator, bool> _insert_hashed(V&& value, size_t h) {
+		Node* temp = _find(value.first, h);
+		if (temp != end_) return sjtu::pair<iterator, bool>(iterator(temp), false);
+		return sjtu::pair<iterator, bool>(iterator(_insert(std::forward<V>(value), h)), true);
 	}
 
+	iterator _find_hashed(const Key& key, size_t h) { return iterator(_find(key, h)); }
+	const_iterator _find_hashed(const Key& key, size_t h) const { return const_iterator(_find(key, h)); }
+
 public:
-	linked_hashmap() :size_(0), table_(10, nullptr) {
-		end_ = static_cast<Node*>(operator new(sizeof(Node)));
-		end_->next_ = end_->prev_ = end_;
-		end_->id = this;
+	// 空的linked_hashmap不分配内存，第一次插入时才分配桶数组和哨兵
+	linked_hashmap() :linked_hashmap(Allocator()) { }
+
+	explicit linked_hashmap(const Allocator& alloc)
+		:alloc_(alloc), end_(nullptr), table_(alloc), old_table_(alloc), migrate_(0), size_(0), incremental_(false),
+		 auto_shrink_(true), max_load_factor_(1.0f) { }
+
+	linked_hashmap(const linked_hashmap &other)
+		:alloc_(node_traits::select_on_container_copy_construction(other.alloc_)),
+		 end_(nullptr), table_(alloc_), old_table_(alloc_), migrate_(0), size_(0), incremental_(other.incremental_),
+		 auto_shrink_(other.auto_shrink_), max_load_factor_(other.max_load_factor_), hash(other.hash), equal(other.equal) {
+		try {
+			_copy(other);
+		}
+		catch (...) {
+			_destroy();
+			throw;
+		}
 	}
 
-	linked_hashmap(const linked_hashmap &other):size_(0), table_(other.table_.size(), nullptr) {
-		end_ = static_cast<Node*>(operator new(sizeof(Node)));
-		end_->next_ = end_->prev_ = end_;
-		end_->id = this;
-		for (iterator it = other.begin(); it != other.end(); ++it)_insert(*it);
+	// 只交换指针，不分配内存；放在vector等容器里扩容时会移动而不是逐个拷贝
+	linked_hashmap(linked_hashmap &&other)
+		noexcept(std::is_nothrow_move_constructible<Hash>::value && std::is_nothrow_move_constructible<Equal>::value)
+		:alloc_(other.alloc_), end_(nullptr), table_(other.table_.get_allocator()), old_table_(other.table_.get_allocator()),
+		 migrate_(0), size_(0), incremental_(other.incremental_), auto_shrink_(other.auto_shrink_),
+		 max_load_factor_(other.max_load_factor_), hash(std::move(other.hash)), equal(std::move(other.equal)) {
+		_steal(other);
 	}
 
 	linked_hashmap & operator=(const linked_hashmap &other) {
 		if(&other == this) return *this;
-		for (iterator it = begin(); it != end(); ) {
-			Node* temp = it.node_;
-			++it;
-			delete temp;
+		_clear();
+		// 和拷贝构造一样连同配置一起拷贝，先拷配置再插入元素
+		incremental_ = other.incremental_;
+		auto_shrink_ = other.auto_shrink_;
+		max_load_factor_ = other.max_load_factor_;
+		hash = other.hash;
+		equal = other.equal;
+		_copy(other);
+		return *this;
+	}
+
+	// 分配器相同或随移动传播时只交换指针；否则只能逐个移动元素，可能抛出异常
+	linked_hashmap & operator=(linked_hashmap &&other)
+		noexcept((node_traits::propagate_on_container_move_assignment::value || node_traits::is_always_equal::value) &&
+				 std::is_nothrow_move_assignable<Hash>::value && std::is_nothrow_move_assignable<Equal>::value) {
+		if(&other == this) return *this;
+		_destroy();
+		if (node_traits::propagate_on_container_move_assignment::value || alloc_ == other.alloc_) {
+			if constexpr (node_traits::propagate_on_container_move_assignment::value) alloc_ = other.alloc_;
+			_steal(other);
 		}
-		end_->next_ = end_->prev_ = end_;
-		size_ = 0;
-		table_ = vector<Node*>(other.table_.size(), nullptr);
-		for (iterator it = other.begin(); it != other.end(); ++it)_insert(*it);
+		else {  // 分配器不同，不能接管对方的节点，只能逐个移动
+			for (iterator it = other.begin(); it != other.end(); ++it) _insert(std::move(*it), it.node_->hash_);
+			other._clear();
+		}
+		incremental_ = other.incremental_;
+		auto_shrink_ = other.auto_shrink_;
+		max_load_factor_ = other.max_load_factor_;
+		hash = std::move(other.hash);
+		equal = std::move(other.equal);
 		return *this;
 	}
  
 	~linked_hashmap() {
-		for (iterator it = begin(); it != end(); ) {
-			Node* temp = it.node_;
-			++it;
-			delete temp;
-		}
-		size_ = 0;
-		operator delete (end_);
+		_destroy();
 	}
 
 	T & at(const Key& key) {
@@ -280,9 +464,10 @@ public:
 	}
  
 	T & operator[](const Key &key) {
-		Node* pos = _find(key);
+		size_t h = hash(key);
+		Node* pos = _find(key, h);
 		if (pos != end_) return pos->kv_.second;
-		return _insert(value_type(key, T()))->kv_.second;
+		return _insert(value_type(key, T()), h)->kv_.second;
 	}
  
 	const T & operator[](const Key &key) const {
@@ -292,12 +477,14 @@ public:
 	}
 
 public:
+	allocator_type get_allocator() const { return allocator_type(alloc_); }
+
 	// 迭代器相关操作
 	iterator begin() {
-		return end_->next_;
+		return end_ ? end_->next_ : nullptr;
 	}
 	const_iterator begin() const {
-		return end_->next_;
+		return end_ ? end_->next_ : nullptr;
 	}
 	iterator end(){
 		return end_;
@@ -314,26 +501,110 @@ public:
  
 	bool empty() const { return size_ == 0; }
 
+	// 渐进式rehash：扩容/缩容时只换上新的桶数组，之后每次插入、删除搬迁几个桶，
+	// 单次插入的耗时不再随元素个数增长；搬迁期间查找要看新旧两个桶数组
+	void incremental_rehash(bool on) {
+		incremental_ = on;
+		if (!on && !old_table_.empty()) _migrate(old_table_.size());
+	}
+
+	bool incremental_rehash() const { return incremental_; }
+
+	size_t bucket_count() const { return table_.size(); }
+
+	float load_factor() const { return table_.empty() ? 0.0f : static_cast<float>(size_) / table_.size(); }
+
+	float max_load_factor() const { return max_load_factor_; }
+
+	// 平均每桶元素数超过ml时扩容，默认为1；必须为正数
+	void max_load_factor(float ml) {
+		if (!(ml > 0)) throw runtime_error();
+		max_load_factor_ = ml;
+		if (!table_.empty() && size_ > _max_elements()) rehash(0);
+	}
+
+	// 桶数改为不少于n且能按max_load_factor放下现有元素的合法桶数，一次搬完
+	void rehash(size_type n) {
+		size_type need = _min_buckets(size_);
+		n = BucketPolicy::round(n > need ? n : need);
+		if (n == table_.size() && old_table_.empty()) return;
+		if (size_ == 0) {
+			table_ = table_type(n, nullptr, table_.get_allocator());
+			old_table_ = table_type(old_table_.get_allocator());
+			migrate_ = 0;
+			return;
+		}
+		bool incremental = incremental_;
+		incremental_ = false;
+		_rehash(n);
+		incremental_ = incremental;
+	}
+
+	// 预留能放下n个元素的桶，之后插入到n个元素都不会扩容
+	void reserve(size_type n) {
+		if (_min_buckets(n) > table_.size()) rehash(_min_buckets(n));
+	}
+
+	// 关掉后erase不再缩容，适合先删后插的场景；桶数只在rehash时变小
+	void auto_shrink(bool on) { auto_shrink_ = on; }
+
+	bool auto_shrink() const { return auto_shrink_; }
+
 	size_t size() const {return size_; }
  
 	void clear() { _clear(); }
  
-	pair<iterator, bool> insert(const value_type &value) {
-		Node* temp = _find(value.first);
-		if (temp != end_)return sjtu::pair<iterator, bool>(iterator(temp), false);
-		return sjtu::pair<iterator, bool>(iterator(_insert(value)), true);
-	}
+	pair<iterator, bool> insert(const value_type &value) { return _insert_hashed(value, hash(value.first)); }
+
+	pair<iterator, bool> insert(value_type &&value) { return _insert_hashed(std::move(value), hash(value.first)); }
  
 	void erase(iterator pos) {
-		if(pos.node_ == nullptr || pos.node_ == end_ || pos.node_->id != this) throw invalid_iterator();
+		if(pos.node_ == nullptr || pos.node_ == end_) throw invalid_iterator();
+		SJTU_CHECK_ITERATOR(pos.node_->id != this);
 		_erase(pos.node_);
 	}
 
+	// 把pos移到遍历顺序的末尾，O(1)，不改变桶；lru_cache 用它记录最近一次访问
+	void move_to_back(iterator pos) {
+		if(pos.node_ == nullptr || pos.node_ == end_) throw invalid_iterator();
+		SJTU_CHECK_ITERATOR(pos.node_->id != this);
+		Node* node = pos.node_;
+		if (node->next_ == end_) return;
+		node->prev_->next_ = node->next_;
+		node->next_->prev_ = node->prev_;
+		_link_back(node);
+	}
+
 	size_t count(const Key &key) const { return _find(key) != end_ ? 1 : 0; }
 	iterator find(const Key &key) { return iterator(_find(key)); }
 	const_iterator find(const Key &key) const { return const_iterator(_find(key)); }
+
+	// Hash 和 Equal 都声明了 is_transparent 时，可以直接用能和Key比较的类型查找，不构造临时的Key
+	// 要求对相等的键，hash(k) 和 hash(key) 的结果相同
+	template<class K, class H = Hash, class E = Equal, class = detail::transparent_t<H, E>>
+	size_t count(const K &key) const { return _find(key) != end_ ? 1 : 0; }
+	template<class K, class H = Hash, class E = Equal, class = detail::transparent_t<H, E>>
+	iterator find(const K &key) { return iterator(_find(key)); }
+	template<class K, class H = Hash, class E = Equal, class = detail::transparent_t<H, E>>
+	const_iterator find(const K &key) const { return const_iterator(_find(key)); }
+
+	template<class K, class H = Hash, class E = Equal, class = detail::transparent_t<H, E>>
+	T & at(const K &key) {
+		Node* pos = _find(key);
+		if (pos != end_) return pos->kv_.second;
+		throw index_out_of_bound();
+	}
+
+	template<class K, class H = Hash, class E = Equal, class = detail::transparent_t<H, E>>
+	const T & at(const K &key) const {
+		Node* pos = _find(key);
+		if (pos != end_) return pos->kv_.second;
+		throw index_out_of_bound();
+	}
 };
 
+}  // inline namespace SJTU_LAYOUT_NAMESPACE
+
 }
 
 #endif
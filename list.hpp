@@ -3,27 +3,31 @@
 
 #include "exceptions.hpp"
 #include "algorithm.hpp"
+#include "config.hpp"
 
 #include <climits>
 #include <cstddef>
+#include <memory>
 
 namespace sjtu {
 
-template<typename T>
+inline namespace SJTU_LAYOUT_NAMESPACE {
+
+template<typename T, class Allocator = std::allocator<T>>
 class list {
 public:
     using value_type = T;
 	using size_type = size_t;
+	using allocator_type = Allocator;
 
 private:
-    struct Node {
+    struct Node : detail::node_owner<list> {  // 检查模式下带所属容器指针id
         value_type value;
 	    Node* prev_;  // 前一节点
 	    Node* next_;  // 下一节点
-        list* id;
         Node() = default;
-	    Node(const T& v, list* i):value(v), id(i) { }
-	    Node(T&& v, list* i):value(std::move(v)), id(i) { }
+	    Node(const T& v, list* i):detail::node_owner<list>(i), value(v) { }
+	    Node(T&& v, list* i):detail::node_owner<list>(i), value(std::move(v)) { }
 };
 
 public:
@@ -38,35 +42,35 @@ public:
 	    iterator(const const_iterator& rhs) :node_(rhs.node_) { }
 
 	    value_type& operator*() const {
-			if (node_ == nullptr || node_ == node_->id->end_)throw sjtu::invalid_iterator();
+			SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
 			return node_->value; 
 		}
 	    value_type* operator->() const {  // 返回value的指针
-			if (node_ == nullptr || node_ == node_->id->end_)throw sjtu::invalid_iterator();
+			SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
 			return &(node_->value); 
 		}
 
 	    iterator& operator++(){  // end_不允许++
-			if (node_ == nullptr || node_ == node_->id->end_)throw sjtu::invalid_iterator();
+			SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
 		    node_ = node_->next_;
 		    return *this;
 	    }
 
 	    iterator operator++(int){  // end_不允许++
-			if (node_ == nullptr || node_ == node_->id->end_)throw sjtu::invalid_iterator();
+			SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
 		    iterator tmp = *this;
 			node_ = node_->next_;
 		    return tmp;
 	    }
 
 	    iterator& operator--(){  // 第一个节点不允许--
-			if (node_ == nullptr || node_ == node_->id->end_->next_)throw sjtu::invalid_iterator();
+			SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_->next_);
 		    node_ = node_->prev_;
 		    return *this;
 	    }
 
 	    iterator operator--(int){  // 第一个节点不允许--
-			if (node_ == nullptr || node_ == node_->id->end_->next_)throw sjtu::invalid_iterator();
+			SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_->next_);
 		    iterator tmp = *this;
 			node_ = node_->prev_;
 		    return tmp;
@@ -89,35 +93,35 @@ public:
 	    const_iterator(const const_iterator& rhs) :node_(rhs.node_) { }
 
 	    const value_type& operator*() const {
-			if (node_ == nullptr || node_ == node_->id->end_)throw sjtu::invalid_iterator();
+			SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
 			return node_->value; 
 		}
 	    const value_type* operator->() const {
-			if (node_ == nullptr || node_ == node_->id->end_)throw sjtu::invalid_iterator();
+			SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
 			return &(node_->value); 
 		}
 
 	    const_iterator& operator++(){  // end_不允许++
-			if (node_ == nullptr || node_ == node_->id->end_)throw sjtu::invalid_iterator();
+			SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
 		    node_ = node_->next_;
 		    return *this;
 	    }
 
 	    const_iterator operator++(int){  // end_不允许++
-			if (node_ == nullptr || node_ == node_->id->end_)throw sjtu::invalid_iterator();
+			SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
 		    const_iterator tmp = *this;
 			node_ = node_->next_;
 		    return tmp;
 	    }
 
 	    const_iterator& operator--(){  // 第一个节点不允许--
-			if (node_ == nullptr || node_ == node_->id->end_->next_)throw sjtu::invalid_iterator();
-		    node_ = node_->prev;
+			SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_->next_);
+		    node_ = node_->prev_;
 		    return *this;
 	    }
         
 	    const_iterator operator--(int){  // 第一个节点不允许--
-			if (node_ == nullptr || node_ == node_->id->end_->next_)throw sjtu::invalid_iterator();
+			SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_->next_);
 		    const_iterator tmp = *this;
 			node_ = node_->prev_;
 		    return tmp;
@@ -131,12 +135,43 @@ public:
     };
 
 private:
+	using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+	using node_traits = std::allocator_traits<node_allocator>;
+
+	node_allocator alloc_;
 	Node*  end_;  // 指向末尾节点
 	size_type size_;  // 链表长度
 
+	template<class... Args>
+	Node* _new_node(Args&&... args) {
+		Node* p = node_traits::allocate(alloc_, 1);
+		try {
+			node_traits::construct(alloc_, p, std::forward<Args>(args)...);
+		}
+		catch (...) {
+			node_traits::deallocate(alloc_, p, 1);
+			throw;
+		}
+		return p;
+	}
+
+	void _delete_node(Node* p) {
+		node_traits::destroy(alloc_, p);
+		node_traits::deallocate(alloc_, p, 1);
+	}
+
+	// 哨兵节点不构造value，只分配内存
+	void _init_end() {
+		end_ = node_traits::allocate(alloc_, 1);
+#if SJTU_CHECKED_ITERATORS
+		end_->id = this;
+#endif
+		end_->prev_ = end_->next_ = end_;
+	}
+
     Node* _insert(Node* pos, value_type x) {
+        Node* newnode = _new_node(std::move(x), this);
 		++size_;
-        Node* newnode = new Node(x, this);
 		pos->prev_->next_ = newnode;
 		newnode->prev_ = pos->prev_;
 		newnode->next_ = pos;
@@ -149,7 +184,7 @@ private:
         Node* temp = pos->next_;
 		pos->prev_->next_ = pos->next_;
         pos->next_->prev_ = pos->prev_;
-        delete pos;
+        _delete_node(pos);
         return temp;
     }
 
@@ -160,7 +195,8 @@ private:
 
 		while(first != last){
 			auto temp = first->next_;
-			delete first;
+			--size_;
+			_delete_node(first);
 			first = temp;
 		}
   		return last;
@@ -170,31 +206,28 @@ private:
         for (iterator it = begin(); it != end(); ) {
 			Node* temp = it.node_;
 			++it;
-			delete temp;
+			_delete_node(temp);
 		}
 		size_ = 0;
         end_->next_ = end_->prev_ = end_;
     }
 
 public:
-    list():size_(0) {
-  		end_ = static_cast<Node*>(operator new(sizeof(Node)));
-        end_->id = this;
-		end_->prev_ = end_->next_ = end_;
+    list():list(Allocator()) { }
+
+    explicit list(const Allocator& alloc):alloc_(alloc), size_(0) {
+		_init_end();
 	}
 
-    list(size_type n, const T& value):size_(0) {
-  		end_ = static_cast<Node*>(operator new(sizeof(Node)));
-        end_->id = this;
-		end_->prev = end_->next = end_;
-		for(auto i = 0; i < n; ++i)
+    list(size_type n, const T& value, const Allocator& alloc = Allocator()):alloc_(alloc), size_(0) {
+		_init_end();
+		for(size_type i = 0; i < n; ++i)
             _insert(end_, value);
 	}
 
-    list(const list &other):size_(0) {
-  		end_ = static_cast<Node*>(operator new(sizeof(Node)));
-        end_->id = this;
-		end_->prev_ = end_->next_ = end_;
+    list(const list &other):
+		alloc_(node_traits::select_on_container_copy_construction(other.alloc_)), size_(0) {
+		_init_end();
         for(auto it = other.begin(); it != other.end(); ++it)
 			_insert(end_, *it);
     }
@@ -203,10 +236,10 @@ public:
 		for (iterator it = begin(); it != end(); ) {
 			Node* temp = it.node_;
 			++it;
-			delete temp;
+			_delete_node(temp);
 		}
 		size_ = 0;
-		operator delete (end_);
+		node_traits::deallocate(alloc_, end_, 1);
     }
 
     list &operator=(const list &rhs) {
@@ -249,6 +282,8 @@ public:
 		return end();
 	}
 
+	allocator_type get_allocator() const { return allocator_type(alloc_); }
+
 	// 容量相关操作
 	bool empty() const { return size_ == 0; }
 
@@ -279,12 +314,14 @@ public:
 
 	// insert erase push pop clear
     iterator insert(iterator pos, const T &value) {
-        if(pos.node_ == nullptr || pos.node_->id != this) throw sjtu::invalid_iterator();
+        if(pos.node_ == nullptr) throw sjtu::invalid_iterator();
+        SJTU_CHECK_ITERATOR(pos.node_->id != this);
 		return iterator(_insert(pos.node_, value));
     }
 
 	iterator insert(iterator pos, size_type n, const T &value) {
-        if(pos.node_ == nullptr || pos.node_->id != this) throw sjtu::invalid_iterator();
+        if(pos.node_ == nullptr) throw sjtu::invalid_iterator();
+        SJTU_CHECK_ITERATOR(pos.node_->id != this);
 		iterator temp = _insert(pos.node_, value);
 		for(auto i = 1; i != n; ++i)_insert(pos.node_, value);
     	return temp; 
@@ -301,13 +338,14 @@ public:
     }
 
     iterator erase(iterator pos) {
-		if(pos.node_ == nullptr || pos.node_ == end_ || pos.node_->id != this) throw sjtu::invalid_iterator();
+		if(pos.node_ == nullptr || pos.node_ == end_) throw sjtu::invalid_iterator();
+		SJTU_CHECK_ITERATOR(pos.node_->id != this);
 		return iterator(_erase(pos.node_));
 	}
 
 	iterator erase(const_iterator first, const_iterator last){
-		if(first.node_ == nullptr || first.node_->id != this) throw sjtu::invalid_iterator();
-		if(last.node_ == nullptr || last.node_->id != this) throw sjtu::invalid_iterator();
+		if(first.node_ == nullptr || last.node_ == nullptr) throw sjtu::invalid_iterator();
+		SJTU_CHECK_ITERATOR(first.node_->id != this || last.node_->id != this);
 		return iterator(_erase(first.node_, last.node_));
 	}
 
@@ -413,6 +451,8 @@ public:
 	}
 };
 
+}  // inline namespace SJTU_LAYOUT_NAMESPACE
+
 }
 
 #endif //SJTU_LIST_HPP
@@ -0,0 +1,166 @@
+#ifndef SJTU_LRU_CACHE_HPP
+#define SJTU_LRU_CACHE_HPP
+
+#include <functional>
+#include <cstddef>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "linked_hashmap.hpp"
+
+namespace sjtu {
+
+// 每个元素的权重都是1，此时 max_weight 等价于又一个容量上限
+struct lru_unit_weight {
+	template<class Key, class T>
+	size_t operator()(const Key&, const T&) const { return 1; }
+};
+
+inline namespace SJTU_LAYOUT_NAMESPACE {
+
+// 最近最少使用(LRU)缓存，建立在 linked_hashmap 之上：
+// linked_hashmap 的遍历顺序就是访问顺序，最久没用的在最前面，命中时用 move_to_back 挪到末尾，O(1)
+// 元素个数超过 capacity 或总权重超过 max_weight 时从最前面开始淘汰，淘汰前调用 on_evict 设置的回调
+// Weigher(key, value) 给出一个元素的权重（例如字节数），放入时计算一次并记下来
+template<class Key, class T, class Hash = std::hash<Key>, class Equal = std::equal_to<Key>,
+		 class Weigher = lru_unit_weight, class Allocator = std::allocator<pair<Key, T>>>
+class lru_cache {
+public:
+	using size_type = unsigned long long;
+	using evict_callback = std::function<void(const Key&, T&)>;
+
+private:
+	struct Entry {
+		T value;
+		size_t weight;
+		Entry(const T& v, size_t w) :value(v), weight(w) { }
+		Entry(T&& v, size_t w) :value(std::move(v)), weight(w) { }
+	};
+	using entry_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<pair<Key, Entry>>;
+	using map_type = linked_hashmap<Key, Entry, Hash, Equal, entry_allocator>;
+
+	map_type map_;
+	size_type capacity_;
+	size_type max_weight_;
+	size_type weight_ = 0;
+	size_type hits_ = 0;
+	size_type misses_ = 0;
+	size_type evictions_ = 0;
+	Weigher weigher_;
+	evict_callback on_evict_;
+
+	// 从最久没用的开始淘汰，直到满足两个上限
+	void _evict() {
+		while (map_.size() > capacity_ || weight_ > max_weight_) {
+			typename map_type::iterator victim = map_.begin();
+			if (on_evict_) on_evict_(victim->first, victim->second.value);
+			weight_ -= victim->second.weight;
+			map_.erase(victim);
+			++evictions_;
+		}
+	}
+
+	template<class V>
+	bool _put(const Key& key, V&& value) {
+		size_t w = weigher_(key, value);
+		// 容量为0或单个元素就超过上限时放不进缓存，返回false，已有的旧值也删掉
+		if (capacity_ == 0 || w > max_weight_) {
+			erase(key);
+			return false;
+		}
+		// 只查找一次：键已存在时insert不会移走kv，返回已有的位置，再用kv覆盖旧值
+		pair<Key, Entry> kv(key, Entry(std::forward<V>(value), w));
+		pair<typename map_type::iterator, bool> res = map_.insert(std::move(kv));
+		if (res.second) weight_ += w;
+		else {
+			typename map_type::iterator pos = res.first;
+			pos->second.value = std::move(kv.second.value);
+			weight_ = weight_ - pos->second.weight + w;
+			pos->second.weight = w;
+			map_.move_to_back(pos);
+		}
+		_evict();
+		return true;
+	}
+
+public:
+	// max_weight 默认不限制
+	explicit lru_cache(size_type capacity, size_type max_weight = size_type(-1),
+					   const Weigher& weigher = Weigher(), const Allocator& alloc = Allocator())
+		:map_(entry_allocator(alloc)), capacity_(capacity), max_weight_(max_weight), weigher_(weigher) {
+		map_.auto_shrink(false);  // 缓存常年接近满，淘汰时不必缩容
+	}
+
+	// 命中时返回值的指针并把它记为最近使用，否则返回nullptr
+	// 指针在下一次修改缓存之前有效
+	T* get(const Key& key) {
+		typename map_type::iterator pos = map_.find(key);
+		if (pos == map_.end()) {
+			++misses_;
+			return nullptr;
+		}
+		++hits_;
+		map_.move_to_back(pos);
+		return &pos->second.value;
+	}
+
+	// 只查看，不改变访问顺序，也不计入命中统计
+	const T* peek(const Key& key) const {
+		typename map_type::const_iterator pos = map_.find(key);
+		return pos == map_.end() ? nullptr : &pos->second.value;
+	}
+
+	bool contains(const Key& key) const { return map_.count(key) != 0; }
+
+	// 放入或覆盖，并记为最近使用；容量为0或权重超过 max_weight 时不放入，返回false
+	bool put(const Key& key, const T& value) { return _put(key, value); }
+
+	bool put(const Key& key, T&& value) { return _put(key, std::move(value)); }
+
+	// 主动删除不调用淘汰回调
+	bool erase(const Key& key) {
+		typename map_type::iterator pos = map_.find(key);
+		if (pos == map_.end()) return false;
+		weight_ -= pos->second.weight;
+		map_.erase(pos);
+		return true;
+	}
+
+	void clear() {
+		map_.clear();
+		weight_ = 0;
+	}
+
+	// 元素被淘汰之前调用 callback(key, value)，回调里可以把 value 移走
+	void on_evict(evict_callback callback) { on_evict_ = std::move(callback); }
+
+	// 调小上限时立即淘汰
+	void set_capacity(size_type capacity) {
+		capacity_ = capacity;
+		_evict();
+	}
+
+	void set_max_weight(size_type max_weight) {
+		max_weight_ = max_weight;
+		_evict();
+	}
+
+	size_t size() const { return map_.size(); }
+	bool empty() const { return map_.empty(); }
+	size_type capacity() const { return capacity_; }
+	size_type weight() const { return weight_; }
+	size_type max_weight() const { return max_weight_; }
+
+	size_type hits() const { return hits_; }
+	size_type misses() const { return misses_; }
+	size_type evictions() const { return evictions_; }
+
+	void reset_stats() {
+		hits_ = misses_ = evictions_ = 0;
+	}
+};
+
+}  // inline namespace SJTU_LAYOUT_NAMESPACE
+
+}
+
+#endif //SJTU_LRU_CACHE_HPP
@@ -7,38 +7,71 @@
  // only for std::less<T>
 #include <functional>
 #include <cstddef>
+#include <memory>
 #include "utility.hpp"
 #include "exceptions.hpp"
+#include "config.hpp"
 
 namespace sjtu {
 
-    template<class Key, class T, class Compare = std::less<Key>>
+    namespace detail {
+        // 顺序统计用的子树大小（含自身）；不开启时是空基类，不占空间
+        template<bool Enable>
+        struct subtree_size {
+            size_t count;
+        };
+
+        template<>
+        struct subtree_size<false> { };
+    }
+
+    inline namespace SJTU_LAYOUT_NAMESPACE {
+
+    // OrderStatistics 为true时，每个节点多记一个子树大小，支持O(log n)的 rank / select / count_range
+    template<class Key, class T, class Compare = std::less<Key>,
+             class Allocator = std::allocator<pair<const Key, T>>, bool OrderStatistics = false>
     class map {
     public:
         using value_type = pair<const Key, T>;
         using key_type = Key;
         using mapped_type = T;
         using size_type = size_t;
+        using allocator_type = Allocator;
         static const bool RED = true, BLACK = false;
 
     private:
-        struct RBNode {
+        // 根节点的parent是哨兵end_，end_->left指向根（树空时为nullptr），end_->right恒为nullptr
+        // 这样最右节点的后继自然是end_，end_的前驱自然是最右节点
+        struct RBNode : detail::node_owner<map>, detail::subtree_size<OrderStatistics> {  // 检查模式下带所属容器指针id
             RBNode* left;
             RBNode* right;
             RBNode* parent;
             value_type value;
             bool col;
-            map* id;
 
             RBNode() = default;
             RBNode(const value_type& x, map* i, RBNode* p = nullptr, bool color = RED, RBNode* l = nullptr, RBNode* r = nullptr)
-                :value(x), id(i), parent(p), col(color), left(l), right(r) { }
+                :detail::node_owner<map>(i), value(x), parent(p), col(color), left(l), right(r) {
+                if constexpr (OrderStatistics) this->count = 1;
+            }
 
             RBNode(value_type&& x, map* i, RBNode* p = nullptr, bool color = RED, RBNode* l = nullptr, RBNode* r = nullptr)
-                :value(x), id(i), parent(p), col(color), left(l), right(r) { }
+                :detail::node_owner<map>(i), value(std::move(x)), parent(p), col(color), left(l), right(r) {
+                if constexpr (OrderStatistics) this->count = 1;
+            }
 
             ~RBNode() { }
 
+            static size_type count_of(RBNode* pos) {
+                if constexpr (OrderStatistics) return pos ? pos->count : 0;
+                else return 0;
+            }
+
+            // 由左右孩子重新算出子树大小
+            void pull() {
+                if constexpr (OrderStatistics) this->count = 1 + count_of(left) + count_of(right);
+            }
+
             void leftRotate() {
                 if (parent == nullptr) return;
                 RBNode* fa = parent;
@@ -47,6 +80,8 @@ namespace sjtu {
                 if (left) left->parent = fa;
                 left = fa;
                 fa->parent = this;
+                fa->pull();
+                pull();
 
                 parent = gf;
                 if (gf == nullptr) return;
@@ -62,6 +97,8 @@ namespace sjtu {
                 if (right) right->parent = fa;
                 right = fa;
                 fa->parent = this;
+                fa->pull();
+                pull();
 
                 parent = gf;
                 if (gf == nullptr) return;
@@ -123,6 +160,10 @@ namespace sjtu {
         };
 
     private:
+        using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<RBNode>;
+        using node_traits = std::allocator_traits<node_allocator>;
+
+        node_allocator alloc_;
         size_type size_;
         Compare comp_;
         RBNode* root_;
@@ -144,38 +185,26 @@ namespace sjtu {
             value_type* operator->() const { return &(node_->value); }
 
             iterator& operator++() {
-                if (node_ == nullptr) throw sjtu::invalid_iterator();
-                if (node_ == node_->id->end_) throw sjtu::invalid_iterator();
-
-                if (node_ == node_->id->rightmost_) node_ = node_->id->end_;
-                else node_ = node_->next();
+                SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
+                node_ = node_->next();
                 return *this;
             }
 
             iterator operator++(int) {
-                if (node_ == nullptr) throw sjtu::invalid_iterator();
-                if (node_ == node_->id->end_) throw sjtu::invalid_iterator();
-
+                SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
                 iterator temp = *this;
-                if (node_ == node_->id->rightmost_) node_ = node_->id->end_;
-                else node_ = node_->next();
+                node_ = node_->next();
                 return temp;
             }
             iterator& operator--() {
-                if (node_ == nullptr) throw sjtu::invalid_iterator();
-                if (node_ == node_->id->leftmost_) throw sjtu::invalid_iterator();
-
-                if (node_ == node_->id->end_) node_ = node_->id->rightmost_;
-                else node_ = node_->prev();
+                SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->leftmost_);
+                node_ = node_->prev();
                 return *this;
             }
             iterator operator--(int) {
-                if (node_ == nullptr) throw sjtu::invalid_iterator();
-                if (node_ == node_->id->leftmost_) throw sjtu::invalid_iterator();
-
+                SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->leftmost_);
                 iterator temp = *this;
-                if (node_ == node_->id->end_) node_ = node_->id->rightmost_;
-                else node_ = node_->prev();
+                node_ = node_->prev();
                 return temp;
             }
 
@@ -197,38 +226,26 @@ namespace sjtu {
             const value_type* operator->() const { return &(node_->value); }
 
             const_iterator& operator++() {
-                if (node_ == nullptr) throw sjtu::invalid_iterator();
-                if (node_ == node_->id->end_) throw sjtu::invalid_iterator();
-
-                if (node_ == node_->id->rightmost_) node_ = node_->id->end_;
-                else node_ = node_->next();
+                SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
+                node_ = node_->next();
                 return *this;
             }
 
             const_iterator operator++(int) {
-                if (node_ == nullptr) throw sjtu::invalid_iterator();
-                if (node_ == node_->id->end_) throw sjtu::invalid_iterator();
-
+                SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->end_);
                 const_iterator temp = *this;
-                if (node_ == node_->id->rightmost_) node_ = node_->id->end_;
-                else node_ = node_->next();
+                node_ = node_->next();
                 return temp;
             }
             const_iterator& operator--() {
-                if (node_ == nullptr) throw sjtu::invalid_iterator();
-                if (node_ == node_->id->leftmost_) throw sjtu::invalid_iterator();
-
-                if (node_ == node_->id->end_) node_ = node_->id->rightmost_;
-                else node_ = node_->prev();
+                SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->leftmost_);
+                node_ = node_->prev();
                 return *this;
             }
             const_iterator operator--(int) {
-                if (node_ == nullptr) throw sjtu::invalid_iterator();
-                if (node_ == node_->id->leftmost_) throw sjtu::invalid_iterator();
-
+                SJTU_CHECK_ITERATOR(node_ == nullptr || node_ == node_->id->leftmost_);
                 const_iterator temp = *this;
-                if (node_ == node_->id->end_) node_ = node_->id->rightmost_;
-                else node_ = node_->prev();
+                node_ = node_->prev();
                 return temp;
             }
 
@@ -240,6 +257,34 @@ namespace sjtu {
 
     private:
 
+        template<class... Args>
+        RBNode* _new_node(Args&&... args) {
+            RBNode* p = node_traits::allocate(alloc_, 1);
+            try {
+                node_traits::construct(alloc_, p, std::forward<Args>(args)...);
+            }
+            catch (...) {
+                node_traits::deallocate(alloc_, p, 1);
+                throw;
+            }
+            return p;
+        }
+
+        void _delete_node(RBNode* p) {
+            node_traits::destroy(alloc_, p);
+            node_traits::deallocate(alloc_, p, 1);
+        }
+
+        // 哨兵节点不构造value，只分配内存
+        void _init_end() {
+            end_ = node_traits::allocate(alloc_, 1);
+#if SJTU_CHECKED_ITERATORS
+            end_->id = this;
+#endif
+            end_->left = end_->right = end_->parent = nullptr;
+            root_ = leftmost_ = rightmost_ = end_;
+        }
+
         void _solveDoubleRed(RBNode* pos) {
             if (pos == root_) {
                 pos->col = BLACK;
@@ -375,7 +420,8 @@ namespace sjtu {
 
         }
 
-        bool _locate(const Key& key, RBNode*& pos) const {  // 返回true：找到节点
+        template<class K>
+        bool _locate(const K& key, RBNode*& pos) const {  // 返回true：找到节点
             if (pos == end_) return false;
             while (pos) {
                 if (comp_(pos->value.first, key)) {
@@ -391,12 +437,46 @@ namespace sjtu {
             return false;  // root_ = nullptr
         }
 
+        // 带提示的查找：键紧挨着hint（在hint之前或之后）时只比较两三次，不从根往下走
+        // 比最右节点还大时直接挂到最右节点的右边；提示不对时退回_locate
+        bool _locate_hint(const Key& key, RBNode* hint, RBNode*& pos) const {
+            pos = root_;
+            if (pos == end_) return false;
+            if (comp_(rightmost_->value.first, key)) {
+                pos = rightmost_;
+                return false;
+            }
+            if (hint != end_) {
+                if (comp_(key, hint->value.first)) {
+                    RBNode* before = hint == leftmost_ ? nullptr : hint->prev();
+                    if (before == nullptr || comp_(before->value.first, key)) {
+                        pos = hint->left ? before : hint;  // hint有左子树时，前驱的右孩子必为空
+                        return false;
+                    }
+                }
+                else if (comp_(hint->value.first, key)) {
+                    RBNode* after = hint->next();  // hint不是最右节点，后继不是end_
+                    if (comp_(key, after->value.first)) {
+                        pos = hint->right ? after : hint;  // hint有右子树时，后继的左孩子必为空
+                        return false;
+                    }
+                }
+                else {
+                    pos = hint;
+                    return true;
+                }
+            }
+            pos = root_;
+            return _locate(key, pos);
+        }
+
         RBNode* _insert(RBNode* pos, RBNode* newnode) {
             ++size_;
             if (pos == end_) {  // 树为空
                 root_ = leftmost_ = rightmost_ = newnode;
                 newnode->col = BLACK;
-                newnode->parent = nullptr;
+                newnode->parent = end_;
+                end_->left = newnode;
                 return newnode;
             }
 
@@ -405,6 +485,8 @@ namespace sjtu {
 
             if (comp_(pos->value.first, newnode->value.first)) pos->right = newnode;
             else pos->left = newnode;
+            if constexpr (OrderStatistics)
+                for (RBNode* p = pos; p != end_; p = p->parent) ++p->count;
 
             if (pos->col == RED)_solveDoubleRed(newnode);
 
@@ -426,11 +508,9 @@ namespace sjtu {
                 bool suc_is_left = suc->parent->left == suc;
                 if (suc->parent == pos) {
                     if (pos == root_) root_ = suc;
-                    else {
-                        if (pos->parent->left == pos)pos->parent->left = suc;
-                        else pos->parent->right = suc;
-                        suc->parent = pos->parent;
-                    }
+                    if (pos->parent->left == pos)pos->parent->left = suc;  // pos为根时即end_->left
+                    else pos->parent->right = suc;
+                    suc->parent = pos->parent;
                     if (suc_is_left) {
                         if (suc->left) suc->left->parent = pos;
                         pos->left = suc->left;
@@ -450,13 +530,12 @@ namespace sjtu {
                         pos->parent = suc;
                     }
                     std::swap(suc->col, pos->col);
+                    _swap_count(suc, pos);
                 }
                 else {
                     if (pos == root_) root_ = suc;
-                    else {
-                        if (pos->parent->left == pos)pos->parent->left = suc;
-                        else pos->parent->right = suc;
-                    }
+                    if (pos->parent->left == pos)pos->parent->left = suc;
+                    else pos->parent->right = suc;
 
                     if (suc_is_left)suc->parent->left = pos;
                     else suc->parent->right = pos;
@@ -470,15 +549,21 @@ namespace sjtu {
                     std::swap(suc->left, pos->left);
                     std::swap(suc->right, pos->right);
                     std::swap(suc->col, pos->col);
+                    _swap_count(suc, pos);
                 }
             }
-            
+
+            // pos已经是叶子，先从祖先的子树大小里扣掉，调整时的旋转按它不存在来计算
+            if constexpr (OrderStatistics) {
+                pos->count = 0;
+                for (RBNode* p = pos->parent; p != end_; p = p->parent) --p->count;
+            }
             if (pos->col == BLACK)_solveRemoveBlack(pos); 
-            if (pos == root_) leftmost_ = rightmost_ = root_ = end_;
-            else if (pos == pos->parent->left) pos->parent->left = nullptr;
+            if (pos == pos->parent->left) pos->parent->left = nullptr;
             else pos->parent->right = nullptr;
+            if (pos == root_) leftmost_ = rightmost_ = root_ = end_;
 
-            delete pos;
+            _delete_node(pos);
 
             if (leftmost_ == nullptr) {
                 leftmost_ = root_;
@@ -491,37 +576,71 @@ namespace sjtu {
 
         }
 
+        // 交换两个节点在树中的位置时，子树大小跟着位置走
+        static void _swap_count(RBNode* a, RBNode* b) {
+            if constexpr (OrderStatistics) std::swap(a->count, b->count);
+        }
+
         void _clear(RBNode* pos) {
             if (pos == nullptr || pos == end_) return;
             if (pos->left) _clear(pos->left);
             if (pos->right) _clear(pos->right);
-            delete pos;
+            _delete_node(pos);
         }
 
         RBNode* _copy(RBNode* pos, map* i, RBNode* fa) {
             if (pos == nullptr) return nullptr;
-            RBNode* newnode = new RBNode(pos->value, i, fa, pos->col);
+            RBNode* newnode = _new_node(pos->value, i, fa, pos->col);
+            if constexpr (OrderStatistics) newnode->count = pos->count;
             if (pos->left) newnode->left = _copy(pos->left, i, newnode);
             if (pos->right) newnode->right = _copy(pos->right, i, newnode);
             return newnode;
         }
 
+        // 用right串起来的n个有序节点建一棵平衡树，list每用掉一个节点就后移一个
+        // 左右子树大小最多差1，所以空指针只出现在最深的两层；把最深一层（depth == red_depth）染红，
+        // 其余染黑，每条路径的黑节点数就都相同
+        RBNode* _build(RBNode*& list, size_type n, size_type depth, size_type red_depth) {
+            if (n == 0) return nullptr;
+            RBNode* left = _build(list, (n - 1) / 2, depth + 1, red_depth);
+            RBNode* pos = list;
+            list = list->right;
+            pos->left = left;
+            if (left) left->parent = pos;
+            pos->right = _build(list, n - 1 - (n - 1) / 2, depth + 1, red_depth);
+            if (pos->right) pos->right->parent = pos;
+            pos->col = (depth == red_depth && depth != 0) ? RED : BLACK;
+            if constexpr (OrderStatistics) pos->count = n;
+            return pos;
+        }
 
+        // 把链表中的n个节点建成整棵树（树原来为空）
+        void _build_tree(RBNode* list, RBNode* tail, size_type n) {
+            if (n == 0) return;
+            size_type red_depth = 0;  // 最深一层的深度：floor(log2(n))
+            while ((size_type(2) << red_depth) <= n) ++red_depth;
+            leftmost_ = list;
+            rightmost_ = tail;
+            root_ = _build(list, n, 0, red_depth);
+            root_->parent = end_;
+            end_->left = root_;
+            size_ = n;
+        }
 
     public:
 
-        map() :size_(0) {
-            end_ = static_cast<RBNode*>(operator new(sizeof(RBNode)));
-            end_->id = this;
-            root_ = leftmost_ = rightmost_ = end_;
+        map() :map(Allocator()) { }
+
+        explicit map(const Allocator& alloc) :alloc_(alloc), size_(0) {
+            _init_end();
         }
 
-        map(const map& other) :size_(other.size_) {
-            end_ = static_cast<RBNode*>(operator new(sizeof(RBNode)));
-            end_->id = this;
-            root_ = leftmost_ = rightmost_ = end_;
+        map(const map& other)
+            :alloc_(node_traits::select_on_container_copy_construction(other.alloc_)), size_(other.size_) {
+            _init_end();
             if (other.size_ == 0) return;
-            root_ = _copy(other.root_, this, nullptr);
+            root_ = _copy(other.root_, this, end_);
+            end_->left = root_;
 
             leftmost_ = rightmost_ = root_;
             while (leftmost_->left) leftmost_ = leftmost_->left;
@@ -531,7 +650,7 @@ namespace sjtu {
         ~map() {
             _clear(root_);
             size_ = 0;
-            operator delete (end_);
+            node_traits::deallocate(alloc_, end_, 1);
         }
 
         map& operator=(const map& other) {
@@ -540,7 +659,8 @@ namespace sjtu {
             size_ = other.size_;
             root_ = leftmost_ = rightmost_ = end_;
             if (other.size_ == 0) return *this;
-            root_ = _copy(other.root_, this, nullptr);
+            root_ = _copy(other.root_, this, end_);
+            end_->left = root_;
 
             leftmost_ = rightmost_ = root_;
             while (leftmost_->left) leftmost_ = leftmost_->left;
@@ -560,10 +680,25 @@ namespace sjtu {
             throw sjtu::index_out_of_bound();
         }
 
+        // Compare 声明了 is_transparent（如 std::less<>）时，可以直接用能和Key比较的类型查找，不构造临时的Key
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        T& at(const K& key) {
+            RBNode* pos = root_;
+            if (_locate(key, pos))return pos->value.second;
+            throw sjtu::index_out_of_bound();
+        }
+
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        const T& at(const K& key) const {
+            RBNode* pos = root_;
+            if (_locate(key, pos))return pos->value.second;
+            throw sjtu::index_out_of_bound();
+        }
+
         T& operator[](const Key& key) {
             RBNode* pos = root_;
             if (_locate(key, pos))return pos->value.second;
-            return _insert(pos, new RBNode(value_type(key, T()), this, pos))->value.second;
+            return _insert(pos, _new_node(value_type(key, T()), this, pos))->value.second;
         }
 
         const T& operator[](const Key& key) const {
@@ -572,6 +707,8 @@ namespace sjtu {
             throw sjtu::index_out_of_bound();
         }
 
+        allocator_type get_allocator() const { return allocator_type(alloc_); }
+
         //迭代器相关操作
         iterator begin() { return iterator(leftmost_); }
         const_iterator cbegin() const { return const_iterator(leftmost_); }
@@ -585,6 +722,7 @@ namespace sjtu {
         void clear() {
             _clear(root_);
             leftmost_ = rightmost_ = root_ = end_;
+            end_->left = nullptr;
             size_ = 0;
         }
 
@@ -593,18 +731,96 @@ namespace sjtu {
             if (_locate(value.first, pos)) {
                 return pair<iterator, bool>(iterator(pos), false);  // 插入失败，返回找到的节点
             }
-            return pair<iterator, bool>(iterator(_insert(pos, new RBNode(value, this, pos))), true);  // 插入成功，返回插入的节点
+            return pair<iterator, bool>(iterator(_insert(pos, _new_node(value, this, pos))), true);  // 插入成功，返回插入的节点
         }
         pair<iterator, bool> insert(value_type&& value) {
             RBNode* pos = root_;
             if (_locate(value.first, pos)) {
                 return pair<iterator, bool>(iterator(pos), false);  // 插入失败，返回找到的节点
             }
-            return pair<iterator, bool>(iterator(_insert(pos, new RBNode(value, this, pos))), true);  // 插入成功，返回插入的节点
+            return pair<iterator, bool>(iterator(_insert(pos, _new_node(std::move(value), this, pos))), true);  // 插入成功，返回插入的节点
+        }
+
+        // hint指向插入位置之后的元素（或紧挨着的前一个元素）时均摊O(1)；单调递增的键用end()做提示
+        // 键已存在时返回已有的元素
+        iterator insert(const_iterator hint, const value_type& value) {
+            SJTU_CHECK_ITERATOR(hint.node_ == nullptr || hint.node_->id != this);
+            RBNode* pos;
+            if (_locate_hint(value.first, hint.node_, pos)) return iterator(pos);
+            return iterator(_insert(pos, _new_node(value, this, pos)));
+        }
+
+        iterator insert(const_iterator hint, value_type&& value) {
+            SJTU_CHECK_ITERATOR(hint.node_ == nullptr || hint.node_->id != this);
+            RBNode* pos;
+            if (_locate_hint(value.first, hint.node_, pos)) return iterator(pos);
+            return iterator(_insert(pos, _new_node(std::move(value), this, pos)));
+        }
+
+        // 先构造节点才能拿到键，键已存在时把它释放掉
+        template<class... Args>
+        iterator emplace_hint(const_iterator hint, Args&&... args) {
+            SJTU_CHECK_ITERATOR(hint.node_ == nullptr || hint.node_->id != this);
+            RBNode* newnode = _new_node(value_type(std::forward<Args>(args)...), this);
+            RBNode* pos;
+            try {
+                if (_locate_hint(newnode->value.first, hint.node_, pos)) {
+                    _delete_node(newnode);
+                    return iterator(pos);
+                }
+            }
+            catch (...) {
+                _delete_node(newnode);
+                throw;
+            }
+            newnode->parent = pos;
+            return iterator(_insert(pos, newnode));
+        }
+
+        // 用按键升序排列的[first, last)替换全部内容，O(n)建树，不做逐个查找和旋转
+        // 相等的键只保留第一个；遇到逆序的键时，之前的部分照常建树，之后的逐个insert
+        // 分配节点时抛出异常的话，map为空
+        template<class InputIt>
+        void assign_sorted(InputIt first, InputIt last) {
+            clear();
+            RBNode* head = nullptr;
+            RBNode* tail = nullptr;
+            size_type n = 0;
+            RBNode* node = nullptr;  // 已分配、还没接到链表上的节点；比较时抛出异常也要释放它
+            try {
+                for (; first != last; ++first) {
+                    node = _new_node(*first, this);
+                    if (tail && !comp_(tail->value.first, node->value.first)) {
+                        bool unsorted = comp_(node->value.first, tail->value.first);
+                        _delete_node(node);
+                        node = nullptr;
+                        if (unsorted) break;
+                        continue;
+                    }
+                    node->right = nullptr;
+                    if (tail) tail->right = node;
+                    else head = node;
+                    tail = node;
+                    node = nullptr;
+                    ++n;
+                }
+            }
+            catch (...) {
+                if (node) _delete_node(node);
+                while (head) {
+                    RBNode* next = head->right;
+                    _delete_node(head);
+                    head = next;
+                }
+                throw;
+            }
+            _build_tree(head, tail, n);
+            for (; first != last; ++first) insert(*first);
         }
 
         void erase(iterator pos) {
-            if (pos.node_->id != this || pos.node_ == end_) throw sjtu::invalid_iterator();
+            if (pos.node_ == nullptr || pos.node_ == end_) throw sjtu::invalid_iterator();
+            SJTU_CHECK_ITERATOR(pos.node_->id != this);
             _erase(pos.node_);
         }
 
@@ -623,8 +839,78 @@ namespace sjtu {
             if (_locate(key, pos)) return const_iterator(pos);
             return cend();
         }
+
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        size_t count(const K& key) const {
+            RBNode* pos = root_;
+            return _locate(key, pos) ? 1 : 0;
+        }
+
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        iterator find(const K& key) {
+            RBNode* pos = root_;
+            if (_locate(key, pos)) return iterator(pos);
+            return end();
+        }
+
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        const_iterator find(const K& key) const {
+            RBNode* pos = root_;
+            if (_locate(key, pos)) return const_iterator(pos);
+            return cend();
+        }
+
+        // 以下需要 OrderStatistics 为true
+
+        // 小于key的元素个数
+        size_t rank(const Key& key) const {
+            static_assert(OrderStatistics, "rank requires OrderStatistics = true");
+            size_t less = 0;
+            RBNode* pos = root_ == end_ ? nullptr : root_;
+            while (pos) {
+                if (comp_(pos->value.first, key)) {
+                    less += RBNode::count_of(pos->left) + 1;
+                    pos = pos->right;
+                }
+                else pos = pos->left;
+            }
+            return less;
+        }
+
+        // 第k小的元素（从0开始），k >= size() 时抛出 index_out_of_bound
+        iterator select(size_t k) {
+            return iterator(_select(k));
+        }
+
+        const_iterator select(size_t k) const {
+            return const_iterator(_select(k));
+        }
+
+        // 键在[low, high)中的元素个数
+        size_t count_range(const Key& low, const Key& high) const {
+            if (!comp_(low, high)) return 0;
+            return rank(high) - rank(low);
+        }
+
+    private:
+        RBNode* _select(size_t k) const {
+            static_assert(OrderStatistics, "select requires OrderStatistics = true");
+            if (k >= size_) throw sjtu::index_out_of_bound();
+            RBNode* pos = root_;
+            while (true) {
+                size_t left = RBNode::count_of(pos->left);
+                if (k < left) pos = pos->left;
+                else if (k == left) return pos;
+                else {
+                    k -= left + 1;
+                    pos = pos->right;
+                }
+            }
+        }
     };
 
+    }  // inline namespace SJTU_LAYOUT_NAMESPACE
+
 }
 
 #endif
@@ -0,0 +1,182 @@
+#ifndef SJTU_NODE_POOL_HPP
+#define SJTU_NODE_POOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace sjtu {
+
+// 定长内存池：从整块(chunk)中依次切出大小相同的块，释放的块挂到空闲链表上，下次分配优先复用
+// chunk 只在池析构时统一归还，不是线程安全的
+class node_pool {
+private:
+    struct Chunk { Chunk* next; };
+    struct FreeBlock { FreeBlock* next; };
+
+    static constexpr size_t min_blocks_per_chunk = 16;
+    static constexpr size_t max_blocks_per_chunk = 1024;
+    static constexpr size_t header_size =
+        (sizeof(Chunk) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+    size_t block_size_;
+    size_t blocks_per_chunk_ = min_blocks_per_chunk;  // 下一个chunk的块数，逐次翻倍到上限
+    Chunk* chunks_ = nullptr;
+    FreeBlock* free_ = nullptr;
+    char* cur_ = nullptr;  // 当前chunk中还没切出去的部分 [cur_, end_)
+    char* end_ = nullptr;
+
+    void _new_chunk() {
+        char* mem = static_cast<char*>(::operator new(header_size + block_size_ * blocks_per_chunk_));
+        Chunk* chunk = reinterpret_cast<Chunk*>(mem);
+        chunk->next = chunks_;
+        chunks_ = chunk;
+        cur_ = mem + header_size;
+        end_ = cur_ + block_size_ * blocks_per_chunk_;
+        if (blocks_per_chunk_ < max_blocks_per_chunk) blocks_per_chunk_ *= 2;
+    }
+
+public:
+    node_pool(size_t size, size_t align) {
+        if (align < alignof(FreeBlock)) align = alignof(FreeBlock);
+        if (size < sizeof(FreeBlock)) size = sizeof(FreeBlock);
+        block_size_ = (size + align - 1) / align * align;
+    }
+
+    node_pool(const node_pool&) = delete;
+    node_pool& operator=(const node_pool&) = delete;
+
+    ~node_pool() {
+        while (chunks_) {
+            Chunk* temp = chunks_->next;
+            ::operator delete(static_cast<void*>(chunks_));
+            chunks_ = temp;
+        }
+    }
+
+    size_t block_size() const { return block_size_; }
+
+    void* allocate() {
+        if (free_) {
+            FreeBlock* block = free_;
+            free_ = block->next;
+            return block;
+        }
+        if (cur_ == end_) _new_chunk();
+        void* block = cur_;
+        cur_ += block_size_;
+        return block;
+    }
+
+    void deallocate(void* p) {
+        FreeBlock* block = static_cast<FreeBlock*>(p);
+        block->next = free_;
+        free_ = block;
+    }
+};
+
+namespace detail {
+
+    // 一组按块大小区分的 node_pool，rebind 之后的分配器共享同一组
+    // 容器一般只会用到一两种块大小（节点、哨兵），线性查找即可
+    class pool_resource {
+    private:
+        struct Entry {
+            node_pool pool;
+            size_t align;
+            Entry* next;
+            Entry(size_t size, size_t a, Entry* n) :pool(size, a), align(a), next(n) { }
+        };
+        Entry* head_ = nullptr;
+
+    public:
+        pool_resource() = default;
+        pool_resource(const pool_resource&) = delete;
+        pool_resource& operator=(const pool_resource&) = delete;
+
+        ~pool_resource() {
+            while (head_) {
+                Entry* temp = head_->next;
+                delete head_;
+                head_ = temp;
+            }
+        }
+
+        node_pool& get(size_t size, size_t align) {
+            node_pool probe(size, align);
+            for (Entry* pos = head_; pos; pos = pos->next)
+                if (pos->pool.block_size() == probe.block_size() && pos->align >= align) return pos->pool;
+            head_ = new Entry(size, align, head_);
+            return head_->pool;
+        }
+    };
+
+}
+
+// 从 node_pool 中分配单个对象的分配器，用于 list / map / linked_hashmap 的节点：
+//     sjtu::list<int, sjtu::pool_allocator<int>>
+//     sjtu::map<int, int, std::less<int>, sjtu::pool_allocator<sjtu::pair<const int, int>>>
+// 一次分配多个对象（如 vector 的缓冲区）或超对齐类型直接交给 std::allocator
+// 拷贝（包括 rebind）出来的分配器共享同一组池；拷贝构造容器时换一组新池，
+// 两个容器不会共享池，所以可以分别交给不同线程
+template<class T>
+class pool_allocator {
+    template<class U> friend class pool_allocator;
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+private:
+    static constexpr bool poolable_ = alignof(T) <= alignof(std::max_align_t);
+
+    std::shared_ptr<detail::pool_resource> resource_;
+    node_pool* pool_ = nullptr;  // resource_ 中对应 T 的池，第一次用到时查找
+
+    node_pool& _pool() {
+        if (pool_ == nullptr) pool_ = &resource_->get(sizeof(T), alignof(T));
+        return *pool_;
+    }
+
+public:
+    pool_allocator() :resource_(std::make_shared<detail::pool_resource>()) { }
+
+    pool_allocator(const pool_allocator& other) noexcept
+        :resource_(other.resource_), pool_(other.pool_) { }
+
+    template<class U>
+    pool_allocator(const pool_allocator<U>& other) noexcept :resource_(other.resource_) { }
+
+    pool_allocator& operator=(const pool_allocator& other) noexcept {
+        resource_ = other.resource_;
+        pool_ = other.pool_;
+        return *this;
+    }
+
+    T* allocate(size_t n) {
+        if (n != 1 || !poolable_) return std::allocator<T>().allocate(n);
+        return static_cast<T*>(_pool().allocate());
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (n != 1 || !poolable_) std::allocator<T>().deallocate(p, n);
+        else _pool().deallocate(p);
+    }
+
+    pool_allocator select_on_container_copy_construction() const {
+        return pool_allocator();
+    }
+
+    template<class U>
+    bool operator==(const pool_allocator<U>& rhs) const { return resource_ == rhs.resource_; }
+
+    template<class U>
+    bool operator!=(const pool_allocator<U>& rhs) const { return resource_ != rhs.resource_; }
+};
+
+}
+
+#endif //SJTU_NODE_POOL_HPP
@@ -3,20 +3,22 @@
 
 #include <cstddef>
 #include <functional>
+#include <memory>
 #include "exceptions.hpp"
 #include "vector.hpp"
 
 namespace sjtu {
 
-template<typename T, class Compare = std::less<T>>
+template<typename T, class Compare = std::less<T>, class Allocator = std::allocator<T>>
 class priority_queue {
 public:
     // types
     using value_type = T;
     using size_type = unsigned long long;
+    using allocator_type = Allocator;
 
 private:
-	vector<T> array_;
+	vector<T, Allocator> array_;
 	Compare comp_;
 
 T& get(size_type x) {
@@ -33,6 +35,9 @@ public:
 	priority_queue():array_() {
 	}
 
+	explicit priority_queue(const Allocator& alloc):array_(alloc) {
+	}
+
 	priority_queue(const priority_queue &other):array_(other.array_) {
 	}
 
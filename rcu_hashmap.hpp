@@ -0,0 +1,179 @@
+#ifndef SJTU_RCU_HASHMAP_HPP
+#define SJTU_RCU_HASHMAP_HPP
+
+#include <atomic>
+#include <functional>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "linked_hashmap.hpp"
+
+namespace sjtu {
+
+inline namespace SJTU_LAYOUT_NAMESPACE {
+
+// 读多写少的哈希表（RCU 风格）：
+// 当前版本是一个发布出去之后不再修改的 linked_hashmap，读者不加锁，只在读前后给自己的读者槽计数加减一，
+// 读操作没有循环也不等待写者，是 wait-free 的
+// 写者（互斥）拷贝当前版本、在副本上修改，再用一次原子写发布新版本；
+// 然后翻转两次纪元，每次等上一纪元进入的读者全部离开（宽限期），两种奇偶都等过之后释放旧版本
+// 新读者记在新纪元的计数上，读者再多也不会让宽限期一直等下去
+// 写操作要拷贝整张表，适合配置表、路由表这类很少修改的数据；多处修改请用 update 一次完成
+template<class Key, class T, class Hash = std::hash<Key>, class Equal = std::equal_to<Key>,
+		 class Allocator = std::allocator<pair<Key, T>>>
+class rcu_hashmap {
+public:
+	using value_type = pair<Key, T>;
+	using size_type = unsigned long long;
+	using allocator_type = Allocator;
+	using map_type = linked_hashmap<Key, T, Hash, Equal, Allocator>;
+
+private:
+	static constexpr size_t reader_slots = 64;
+
+	// 每个线程固定使用一个读者槽，槽数不够时几个线程共用；active[e] 是纪元奇偶为e时进入的读者数
+	struct alignas(64) ReaderSlot {
+		std::atomic<size_type> active[2];
+		ReaderSlot() { active[0] = 0; active[1] = 0; }
+	};
+
+	std::atomic<const map_type*> current_;
+	std::atomic<size_type> epoch_;
+	mutable ReaderSlot slots_[reader_slots];
+	std::mutex writer_mutex_;
+
+	static size_t _slot_index() {
+		static std::atomic<size_t> next(0);
+		thread_local size_t index = next.fetch_add(1) % reader_slots;
+		return index;
+	}
+
+	// 读临界区：构造时登记，析构时离开；期间读到的版本不会被释放
+	class read_guard {
+	private:
+		std::atomic<size_type>* counter_;
+	public:
+		const map_type* map;
+
+		// 读到纪元和计数加一之间可能已经有写者翻转了纪元，计数会记在过时的奇偶上；
+		// 写者两种奇偶都等，所以记在哪一边都会被等到，读者不必重试
+		explicit read_guard(const rcu_hashmap& owner) {
+			size_type epoch = owner.epoch_.load();
+			counter_ = &owner.slots_[_slot_index()].active[epoch & 1];
+			counter_->fetch_add(1);
+			map = owner.current_.load();
+		}
+
+		read_guard(const read_guard&) = delete;
+		read_guard& operator=(const read_guard&) = delete;
+
+		~read_guard() { counter_->fetch_sub(1); }
+	};
+
+	// 发布新版本，等宽限期结束后释放旧版本；调用前必须持有 writer_mutex_
+	// 读到旧版本的读者在 exchange 之前就已登记，但登记的奇偶可能是任意过时纪元的；
+	// 翻转两次、两种奇偶的计数各等一次清零，无论它记在哪一边都会被等到
+	void _publish(const map_type* next) {
+		const map_type* old = current_.exchange(next);
+		for (int phase = 0; phase != 2; ++phase) {
+			size_type epoch = epoch_.fetch_add(1);
+			for (ReaderSlot& slot : slots_) {
+				while (slot.active[epoch & 1].load() != 0) std::this_thread::yield();
+			}
+		}
+		delete old;
+	}
+
+public:
+	rcu_hashmap() :current_(new map_type()), epoch_(0) { }
+
+	explicit rcu_hashmap(const Allocator& alloc) :current_(new map_type(alloc)), epoch_(0) { }
+
+	rcu_hashmap(const rcu_hashmap&) = delete;
+	rcu_hashmap& operator=(const rcu_hashmap&) = delete;
+
+	// 析构时不能再有读者
+	~rcu_hashmap() {
+		delete current_.load();
+	}
+
+	// 读操作，不加锁
+
+	bool find(const Key& key, T& out) const {
+		read_guard guard(*this);
+		typename map_type::const_iterator pos = guard.map->find(key);
+		if (pos == guard.map->cend()) return false;
+		out = pos->second;
+		return true;
+	}
+
+	T at(const Key& key) const {
+		read_guard guard(*this);
+		return guard.map->at(key);
+	}
+
+	size_t count(const Key& key) const {
+		read_guard guard(*this);
+		return guard.map->count(key);
+	}
+
+	size_t size() const {
+		read_guard guard(*this);
+		return guard.map->size();
+	}
+
+	bool empty() const { return size() == 0; }
+
+	// 在读临界区内调用 f(const map_type&) 并返回它的结果，可以在同一个版本上做多次查找或遍历
+	// f 返回之后 map 的引用不再有效
+	template<class F>
+	auto read(F f) const -> decltype(f(std::declval<const map_type&>())) {
+		read_guard guard(*this);
+		return f(*guard.map);
+	}
+
+	// 写操作，互斥执行，每次生成并发布一个新版本
+
+	// 在当前版本的副本上调用 f(map_type&)，然后发布
+	template<class F>
+	void update(F f) {
+		std::lock_guard<std::mutex> lock(writer_mutex_);
+		std::unique_ptr<map_type> next(new map_type(*current_.load()));
+		f(*next);
+		_publish(next.release());
+	}
+
+	// 整体替换成 map
+	void assign(map_type map) {
+		std::lock_guard<std::mutex> lock(writer_mutex_);
+		_publish(new map_type(std::move(map)));
+	}
+
+	void insert_or_assign(const Key& key, const T& value) {
+		update([&](map_type& map) { map[key] = value; });
+	}
+
+	bool erase(const Key& key) {
+		bool found = false;
+		update([&](map_type& map) {
+			typename map_type::iterator pos = map.find(key);
+			if (pos == map.end()) return;
+			map.erase(pos);
+			found = true;
+		});
+		return found;
+	}
+
+	void clear() {
+		assign(map_type());
+	}
+};
+
+}  // inline namespace SJTU_LAYOUT_NAMESPACE
+
+}
+
+#endif //SJTU_RCU_HASHMAP_HPP
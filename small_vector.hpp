@@ -0,0 +1,543 @@
+#ifndef SJTU_SMALL_VECTOR_HPP
+#define SJTU_SMALL_VECTOR_HPP
+
+#include "vector.hpp"
+
+namespace sjtu {
+
+//前N个元素放在对象自带的缓冲区里，超过N个才去堆上分配，接口和vector相同
+//默认构造不分配任何内存；元素在内部缓冲区时，移动small_vector需要逐个搬移元素
+template <class T, size_t N, class Allocator = std::allocator<T>>
+class small_vector{
+    static_assert(N > 0, "small_vector needs at least one inline element");
+
+public:
+
+    using value_type = T;
+    using allocator_type = Allocator;
+    using iterator = value_type*;
+    using const_iterator = const value_type*;
+    using size_type = size_t;
+
+private:
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+    static_assert(std::is_same<typename alloc_traits::value_type, T>::value,
+        "allocator_type::value_type must be T");
+    static_assert(std::is_same<typename alloc_traits::pointer, T*>::value,
+        "only allocators with raw pointers are supported");
+
+    Allocator alloc_;
+    iterator begin_;
+    size_type currentsize_ = 0;
+    size_type maxsize_ = N;
+    alignas(T) unsigned char buffer_[N * sizeof(T)];  // 内部缓冲区
+
+    iterator _inline() {
+        return reinterpret_cast<T*>(buffer_);
+    }
+
+    bool _is_inline() const {
+        return begin_ == reinterpret_cast<const T*>(buffer_);
+    }
+
+    iterator _allocate(size_type n){
+        return alloc_traits::allocate(alloc_, n);
+    }
+
+    //释放堆上的缓冲区（在内部缓冲区时什么都不做）
+    void _release(){
+        if(!_is_inline()) alloc_traits::deallocate(alloc_, begin_, maxsize_);
+    }
+
+    //换到容量为n的缓冲区，n <= N 时换回内部缓冲区
+    void _reallocate(size_type n){
+        if(n <= N){
+            if(_is_inline()) return;
+            detail::relocate(alloc_, _inline(), begin_, currentsize_);
+            alloc_traits::deallocate(alloc_, begin_, maxsize_);
+            begin_ = _inline();
+            maxsize_ = N;
+            return;
+        }
+        iterator temp_begin_ = _allocate(n);
+        try{
+            detail::relocate(alloc_, temp_begin_, begin_, currentsize_);
+        }
+        catch(...){
+            alloc_traits::deallocate(alloc_, temp_begin_, n);
+            throw;
+        }
+        _release();
+        begin_ = temp_begin_;
+        maxsize_ = n;
+    }
+
+    //扩容到能放下required个元素，扩容之后一定在堆上
+    size_type _grow(size_type required) const {
+        return growth_2x::grow(maxsize_, required);
+    }
+
+    //已经在temp_begin_(容量n)的[index, index + count)构造好了新元素，把旧元素搬过去
+    //搬移失败时析构新元素、释放temp_begin_，旧元素不受影响
+    void _adopt(iterator temp_begin_, size_type n, size_type index, size_type count){
+        try{
+            detail::relocate_gap(alloc_, temp_begin_, begin_, currentsize_, index, count);
+        }
+        catch(...){
+            for(size_type i = index; i != index + count; ++i) alloc_traits::destroy(alloc_, temp_begin_ + i);
+            alloc_traits::deallocate(alloc_, temp_begin_, n);
+            throw;
+        }
+        _release();
+        begin_ = temp_begin_;
+        maxsize_ = n;
+        currentsize_ += count;
+    }
+
+    template<class... Args>
+    void _realloc_emplace(size_type index, Args&&... args){
+        size_type n = _grow(currentsize_ + 1);
+        iterator temp_begin_ = _allocate(n);
+        try{
+            alloc_traits::construct(alloc_, temp_begin_ + index, std::forward<Args>(args)...);
+        }
+        catch(...){
+            alloc_traits::deallocate(alloc_, temp_begin_, n);
+            throw;
+        }
+        _adopt(temp_begin_, n, index, 1);
+    }
+
+    template<class... Args>
+    iterator _emplace(size_type index, Args&&... args){
+        if(currentsize_ == maxsize_){
+            _realloc_emplace(index, std::forward<Args>(args)...);
+        }
+        else if(index == currentsize_){
+            alloc_traits::construct(alloc_, begin_ + index, std::forward<Args>(args)...);
+            ++currentsize_;
+        }
+        else{
+            value_type temp(std::forward<Args>(args)...);
+            detail::relocate_overlap(alloc_, begin_ + index + 1, begin_ + index, currentsize_ - index);
+            alloc_traits::construct(alloc_, begin_ + index, std::move(temp));
+            ++currentsize_;
+        }
+        return begin_ + index;
+    }
+
+    template<class ForwardIt>
+    iterator _insert_range(size_type index, ForwardIt first, size_type n){
+        if(n == 0) return begin_ + index;
+        if(currentsize_ + n <= maxsize_){
+            detail::relocate_overlap(alloc_, begin_ + index + n, begin_ + index, currentsize_ - index);
+            try{
+                detail::construct_range(alloc_, begin_ + index, first, n);
+            }
+            catch(...){
+                detail::relocate_overlap(alloc_, begin_ + index, begin_ + index + n, currentsize_ - index);
+                throw;
+            }
+            currentsize_ += n;
+        }
+        else{
+            size_type new_maxsize_ = _grow(currentsize_ + n);
+            iterator temp_begin_ = _allocate(new_maxsize_);
+            try{
+                detail::construct_range(alloc_, temp_begin_ + index, first, n);
+            }
+            catch(...){
+                alloc_traits::deallocate(alloc_, temp_begin_, new_maxsize_);
+                throw;
+            }
+            _adopt(temp_begin_, new_maxsize_, index, n);
+        }
+        return begin_ + index;
+    }
+
+    //接管rhs的元素，调用前自己必须是空的且在内部缓冲区
+    void _steal(small_vector& rhs){
+        if(rhs._is_inline()){
+            detail::relocate(alloc_, begin_, rhs.begin_, rhs.currentsize_);
+        }
+        else{
+            begin_ = rhs.begin_;
+            maxsize_ = rhs.maxsize_;
+            rhs.begin_ = rhs._inline();
+            rhs.maxsize_ = N;
+        }
+        currentsize_ = rhs.currentsize_;
+        rhs.currentsize_ = 0;
+    }
+
+public:
+
+#pragma region default constructor, copy constructor, Destructor
+
+    small_vector() noexcept(noexcept(Allocator())) :small_vector(Allocator()) { }
+
+    explicit small_vector(const Allocator& alloc) noexcept :alloc_(alloc), begin_(_inline()) { }
+
+    small_vector(size_type n, const Allocator& alloc = Allocator()) :small_vector(alloc) {
+        reserve(n);
+    }
+
+    small_vector(size_type n, const value_type& value, const Allocator& alloc = Allocator()) :small_vector(alloc) {
+        insert(end(), n, value);
+    }
+
+    template<class InputIt, class = detail::enable_if_iterator<InputIt>>
+    small_vector(InputIt first, InputIt last, const Allocator& alloc = Allocator()) :small_vector(alloc) {
+        insert(end(), first, last);
+    }
+
+    small_vector(const small_vector& rhs)
+        :small_vector(alloc_traits::select_on_container_copy_construction(rhs.alloc_)) {
+        _insert_range(0, rhs.begin_, rhs.currentsize_);
+    }
+
+    small_vector(small_vector&& rhs) noexcept(std::is_nothrow_move_constructible<T>::value)
+        :small_vector(std::move(rhs.alloc_)) {
+        _steal(rhs);
+    }
+
+    ~small_vector(){
+        clear();
+        _release();
+    }
+#pragma endregion
+
+#pragma region Assignment operator
+
+    small_vector& operator=(const small_vector& rhs) {
+        if(this == &rhs) return *this;
+        clear();
+        if constexpr (alloc_traits::propagate_on_container_copy_assignment::value){
+            if(alloc_ != rhs.alloc_){  // 旧内存必须用旧的分配器释放
+                _release();
+                begin_ = _inline();
+                maxsize_ = N;
+            }
+            alloc_ = rhs.alloc_;
+        }
+        _insert_range(0, rhs.begin_, rhs.currentsize_);
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& rhs) {
+        if(this == &rhs) return *this;
+        clear();
+        bool steal = alloc_traits::propagate_on_container_move_assignment::value ||
+                     alloc_traits::is_always_equal::value || alloc_ == rhs.alloc_;
+        if(!steal){  // 分配器不同，不能接管对方的堆内存，只能逐个移动
+            reserve(rhs.size());
+            for(size_type i = 0; i != rhs.size(); ++i)
+                emplace_back(std::move(*(rhs.begin_ + i)));
+            rhs.clear();
+            return *this;
+        }
+        _release();
+        begin_ = _inline();
+        maxsize_ = N;
+        if constexpr (alloc_traits::propagate_on_container_move_assignment::value)
+            alloc_ = std::move(rhs.alloc_);
+        _steal(rhs);
+        return *this;
+    }
+#pragma endregion
+
+#pragma region 迭代器相关操作
+
+    iterator begin() {
+        return begin_;
+    }
+
+    const_iterator begin() const {
+        return begin_;
+    }
+
+    iterator end() {
+        return begin_ + currentsize_;
+    }
+
+    const_iterator end() const {
+        return begin_ + currentsize_;
+    }
+
+    const_iterator cbegin() const {
+        return begin();
+    }
+
+    const_iterator cend() const {
+        return end();
+    }
+#pragma endregion
+
+#pragma region 容量相关操作 empty(), size(), capacity(), clear()
+
+    bool empty() const {
+        return currentsize_ == 0;
+    }
+
+    size_type size() const {
+        return currentsize_;
+    }
+
+    size_type capacity() const {
+        return maxsize_;
+    }
+
+    //元素是否还放在内部缓冲区里
+    bool is_inline() const {
+        return _is_inline();
+    }
+
+    void clear(){
+        for (size_type i = 0; i != currentsize_; i++)
+            alloc_traits::destroy(alloc_, begin_ + i);
+        currentsize_ = 0;
+    }
+#pragma endregion
+
+    //扩容
+    void reserve(size_type n){
+        if(n <= capacity()) return;
+        _reallocate(n);
+    }
+
+    //缩容到数据数量，放得下时搬回内部缓冲区
+    void shrink_to_fit(){
+        if(_is_inline() || size() == capacity()) return;
+        _reallocate(size());
+    }
+
+    void assign(size_type n, const T& value){
+        clear();
+        insert(end(), n, value);
+    }
+
+    //改变元素个数，多了则填充数据
+    void resize(size_type n, const value_type& value){
+        if(n < size()){
+            for(size_type i = n; i != size(); i++){
+                alloc_traits::destroy(alloc_, begin_ + i);
+            }
+            currentsize_ = n;
+        }
+        else {
+            insert(end(), n - size(), value);
+        }
+    }
+
+    void resize(size_type n){
+        resize(n, value_type());
+    }
+
+#pragma region 访问元素
+
+    value_type& operator[](size_type n) {
+#if SJTU_CHECKED_SUBSCRIPT
+        if(n >= size()) throw index_out_of_bound();
+#endif
+        return *(begin_ + n);
+    }
+
+    const value_type& operator[](size_type n) const {
+#if SJTU_CHECKED_SUBSCRIPT
+        if(n >= size()) throw index_out_of_bound();
+#endif
+        return *(begin_ + n);
+    }
+
+    value_type& at(size_type n) {
+        if(n >= size()) throw index_out_of_bound();//越界
+        return *(begin_ + n);
+    }
+
+    const value_type& at(size_type n) const {
+        if(n >= size()) throw index_out_of_bound();//越界
+        return *(begin_ + n);
+    }
+
+    value_type& front() {
+        if(size() == 0) throw container_is_empty();//空
+        return *begin_;
+    }
+
+    const value_type& front() const {
+        if(size() == 0) throw container_is_empty();//空
+        return *begin_;
+    }
+
+    value_type& back() {
+        if(size() == 0) throw container_is_empty();//空
+        return *(begin_ + currentsize_ - 1);
+    }
+
+    const value_type& back() const {
+        if(size() == 0) throw container_is_empty();//空
+        return *(begin_ + currentsize_ - 1);
+    }
+
+    value_type* data() {
+        return begin_;
+    }
+
+    const value_type* data() const {
+        return begin_;
+    }
+#pragma endregion
+
+#pragma region 插入 insert(), emplace()
+
+    iterator insert(const_iterator pos, size_type n, const value_type& value){
+        size_type index = pos - begin_;
+        if(n == 0) return begin_ + index;
+        if(currentsize_ + n <= maxsize_ && &value >= begin_ && &value < end()){
+            value_type temp(value);  // value在要挪动的区间里，先拷一份
+            return insert(pos, n, temp);
+        }
+        if(currentsize_ + n <= maxsize_){
+            detail::relocate_overlap(alloc_, begin_ + index + n, begin_ + index, currentsize_ - index);
+            size_type i = index;
+            try{
+                for(; i != index + n; ++i){
+                    alloc_traits::construct(alloc_, begin_ + i, value);
+                }
+            }
+            catch(...){  // 析构已构造的部分，把挪走的元素挪回来
+                while(i != index) alloc_traits::destroy(alloc_, begin_ + --i);
+                detail::relocate_overlap(alloc_, begin_ + index, begin_ + index + n, currentsize_ - index);
+                throw;
+            }
+            currentsize_ += n;
+        }
+        else{
+            size_type new_maxsize_ = _grow(currentsize_ + n);
+            iterator temp_begin_ = _allocate(new_maxsize_);
+            size_type i = index;
+            try{
+                for(; i != index + n; ++i){
+                    alloc_traits::construct(alloc_, temp_begin_ + i, value);
+                }
+            }
+            catch(...){
+                while(i != index) alloc_traits::destroy(alloc_, temp_begin_ + --i);
+                alloc_traits::deallocate(alloc_, temp_begin_, new_maxsize_);
+                throw;
+            }
+            _adopt(temp_begin_, new_maxsize_, index, n);
+        }
+        return begin_ + index;
+    }
+
+    iterator insert(const_iterator pos, const value_type& x) {
+        return insert(pos, 1, x);
+    }
+
+    iterator insert(const_iterator pos, T&& x) {
+        return _emplace(pos - begin_, std::move(x));
+    }
+
+    template<class InputIt, class = detail::enable_if_iterator<InputIt>>
+    iterator insert(const_iterator pos, InputIt first, InputIt last) {
+        size_type index = pos - begin_;
+        if constexpr (detail::is_forward_iterator<InputIt>::value){
+            if constexpr (detail::is_pointer_to<InputIt, T>::value){
+                if(first != last && &*first < end() && begin_ < &*first + (last - first)){
+                    small_vector temp(first, last, alloc_);  // 区间来自本容器，先拷出来
+                    return _insert_range(index, temp.begin_, temp.size());
+                }
+            }
+            return _insert_range(index, first, std::distance(first, last));
+        }
+        else if(index == currentsize_){
+            for(; first != last; ++first) emplace_back(*first);
+            return begin_ + index;
+        }
+        else{
+            small_vector temp(first, last, alloc_);
+            return _insert_range(index, std::make_move_iterator(temp.begin_), temp.size());
+        }
+    }
+
+    template<class... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        return _emplace(pos - begin_, std::forward<Args>(args)...);
+    }
+#pragma endregion
+
+#pragma region push(), emplace_back(), pop()
+
+    void push_back(const T& x) {
+        emplace_back(x);
+    }
+
+    void push_back(T&& x) {
+        emplace_back(std::move(x));
+    }
+
+    template<class InputIt, class = detail::enable_if_iterator<InputIt>>
+    void append(InputIt first, InputIt last) {
+        insert(end(), first, last);
+    }
+
+    template<class... Args>
+    value_type& emplace_back(Args&&... args) {
+        if(currentsize_ == maxsize_)
+            _realloc_emplace(currentsize_, std::forward<Args>(args)...);
+        else{
+            alloc_traits::construct(alloc_, begin_ + currentsize_, std::forward<Args>(args)...);
+            ++currentsize_;
+        }
+        return *(begin_ + currentsize_ - 1);
+    }
+
+    void pop_back(){
+        if(size() == 0) throw container_is_empty();//空
+        alloc_traits::destroy(alloc_, end() - 1);
+        --currentsize_;
+    }
+#pragma endregion
+
+#pragma region 删除 erase()
+
+    //不自动缩容，需要时调用shrink_to_fit
+    iterator erase(const_iterator first, const_iterator last){
+        iterator xfirst = const_cast<iterator>(first);
+        iterator xlast = const_cast<iterator>(last);
+        size_type delta = xfirst - cbegin();
+        if(first == last) return begin_ + delta;
+        size_type n = last - first;
+        for(size_type i = 0; i != size() - n - delta; ++i){
+            *(xfirst + i) = std::move(*(xlast + i));
+        }
+        for(size_type i = size() - n; i != size(); ++i){
+            alloc_traits::destroy(alloc_, begin_ + i);
+        }
+        currentsize_ -= n;
+        return begin_ + delta;
+    }
+
+    iterator erase(const_iterator pos){
+        return erase(pos, pos + 1);
+    }
+#pragma endregion
+
+    allocator_type get_allocator() const {
+        return alloc_;
+    }
+
+    void swap(small_vector& rhs) {
+        if (this != &rhs) {
+            small_vector temp(std::move(rhs));
+            rhs = std::move(*this);
+            *this = std::move(temp);
+        }
+    }
+};
+
+}
+
+#endif //SJTU_SMALL_VECTOR_HPP
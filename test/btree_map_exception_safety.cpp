@@ -0,0 +1,94 @@
+// btree_map 插入时节点分配或键的拷贝抛异常，树保持原样：元素不变、节点不超容量、之后还能继续插入
+//     g++ -std=c++17 -g -fsanitize=address,undefined -I.. btree_map_exception_safety.cpp && ./a.out
+#include "btree_map.hpp"
+#include <cassert>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <stdexcept>
+
+std::mt19937 rng(42);
+unsigned fail_percent = 0;  // 每次分配、每次键的拷贝以这个概率抛异常
+
+void maybe_throw() {
+    if (fail_percent != 0 && rng() % 100 < fail_percent) throw std::runtime_error("injected");
+}
+
+// 分配时可能抛异常的分配器
+template<class T>
+struct throwing_allocator {
+    using value_type = T;
+
+    throwing_allocator() = default;
+    template<class U>
+    throwing_allocator(const throwing_allocator<U>&) { }
+
+    T* allocate(size_t n) {
+        maybe_throw();
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n) { std::allocator<T>().deallocate(p, n); }
+
+    template<class U>
+    bool operator==(const throwing_allocator<U>&) const { return true; }
+    template<class U>
+    bool operator!=(const throwing_allocator<U>&) const { return false; }
+};
+
+// 拷贝可能抛异常的键（分裂时要拷贝一个键作为分隔键）
+// pair<const Key, T> 的移动会从 const Key&& 构造键，节点内搬移元素时走这条路，不抛异常
+struct Key {
+    int* p;  // 堆上的值，泄漏或重复析构时 ASan 能报出来
+    explicit Key(int v) :p(new int(v)) { }
+    Key(const Key& o) { maybe_throw(); p = new int(*o.p); }
+    Key(const Key&& o) noexcept :p(new int(*o.p)) { }
+    Key(Key&& o) noexcept :p(o.p) { o.p = nullptr; }
+    ~Key() { delete p; }
+    bool operator<(const Key& o) const { return *p < *o.p; }
+};
+
+using map_type = sjtu::btree_map<Key, int, std::less<Key>, throwing_allocator<sjtu::pair<const Key, int>>>;
+
+void check(const map_type& m, const std::set<int>& expect) {
+    assert(m.size() == expect.size());
+    std::set<int>::const_iterator e = expect.begin();
+    for (map_type::const_iterator it = m.cbegin(); it != m.cend(); ++it, ++e) {
+        assert(*it->first.p == *e && it->second == *e);
+    }
+    for (int k : expect) assert(m.count(Key(k)) == 1);
+}
+
+int main() {
+    for (unsigned percent : {5u, 20u, 50u}) {
+        map_type m;
+        std::set<int> expect;
+        int failures = 0;
+        for (int i = 0; i != 20000; ++i) {
+            int k = int(rng() % 50000);
+            fail_percent = percent;
+            try {
+                Key key(k);  // 构造不会抛
+                m.insert(sjtu::pair<const Key, int>(std::move(key), k));
+                fail_percent = 0;
+                expect.insert(k);
+            }
+            catch (std::runtime_error&) {
+                fail_percent = 0;
+                ++failures;
+            }
+            if (i % 1000 == 0) check(m, expect);
+        }
+        check(m, expect);
+        // 异常之后的树还能正常删除
+        for (int k : std::set<int>(expect)) {
+            if (k % 3 == 0) {
+                m.erase(m.find(Key(k)));
+                expect.erase(k);
+            }
+        }
+        check(m, expect);
+        assert(failures > 0);
+    }
+    puts("ok");
+    return 0;
+}
@@ -0,0 +1,63 @@
+// 拷贝构造和拷贝赋值都要连同 Hash、Equal 一起拷贝；insert 接受右值
+//     g++ -std=c++17 -I.. flat_hashmap_copy.cpp && ./a.out
+#include "flat_hashmap.hpp"
+#include <cassert>
+#include <cstdio>
+#include <string>
+
+// 带状态的哈希和比较，默认构造时取下面两个全局变量作为状态；
+// 模mod同余的键视为同一个键，mod为0时就是普通的相等
+size_t next_seed = 0;
+int next_mod = 0;
+
+struct seeded_hash {
+    size_t seed = next_seed;
+    int mod = next_mod;
+    size_t operator()(int x) const { return std::hash<int>()(mod ? x % mod : x) ^ seed; }
+};
+
+struct mod_equal {
+    int mod = next_mod;
+    bool operator()(int a, int b) const { return mod ? a % mod == b % mod : a == b; }
+};
+
+using map_type = sjtu::flat_hashmap<int, int, seeded_hash, mod_equal>;
+
+map_type make_source() {
+    next_seed = 12345;
+    next_mod = 1000;
+    map_type m;
+    next_seed = 0;
+    next_mod = 0;
+    for (int i = 0; i != 500; ++i) m[i] = i;
+    return m;
+}
+
+void check(map_type& m) {
+    assert(m.size() == 500);
+    for (int i = 0; i != 500; ++i) assert(m.count(i) == 1);
+    assert(m.at(1042) == 42);  // 要用拷贝来的Hash和Equal才能找到
+    m[1042] = 7;  // 之后的插入也按拷贝来的Hash和Equal进行
+    assert(m.size() == 500 && m.at(42) == 7);
+}
+
+int main() {
+    map_type src = make_source();
+
+    map_type copied(src);
+    check(copied);
+
+    map_type assigned;
+    assigned[7] = 7;
+    assigned = src;
+    check(assigned);
+
+    sjtu::flat_hashmap<std::string, std::string> s;
+    std::string key(40, 'k'), value(40, 'v');
+    assert(s.insert(sjtu::pair<std::string, std::string>(std::move(key), std::move(value))).second);
+    assert(s.at(std::string(40, 'k')) == std::string(40, 'v'));
+    assert(!s.insert(sjtu::pair<std::string, std::string>(std::string(40, 'k'), "x")).second);
+
+    puts("ok");
+    return 0;
+}
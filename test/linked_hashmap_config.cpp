@@ -0,0 +1,75 @@
+// 拷贝赋值要连同配置（渐进rehash、自动缩容、最大负载因子、Hash、Equal）一起拷贝
+//     g++ -std=c++17 -I.. linked_hashmap_config.cpp && ./a.out
+#include "linked_hashmap.hpp"
+#include <cassert>
+#include <cstdio>
+
+// 带状态的哈希和比较，默认构造时取下面两个全局变量作为状态；
+// 模mod同余的键视为同一个键，mod为0时就是普通的相等
+size_t next_seed = 0;
+int next_mod = 0;
+
+struct seeded_hash {
+    size_t seed = next_seed;
+    int mod = next_mod;
+    size_t operator()(int x) const { return std::hash<int>()(mod ? x % mod : x) ^ seed; }
+};
+
+struct mod_equal {
+    int mod = next_mod;
+    bool operator()(int a, int b) const { return mod ? a % mod == b % mod : a == b; }
+};
+
+using map_type = sjtu::linked_hashmap<int, int, seeded_hash, mod_equal>;
+
+map_type make_source() {
+    next_seed = 12345;
+    next_mod = 1000;
+    map_type m;
+    next_seed = 0;
+    next_mod = 0;
+    m.incremental_rehash(true);
+    m.auto_shrink(false);
+    m.max_load_factor(0.5f);
+    return m;
+}
+
+void check_config(const map_type& m) {
+    assert(m.incremental_rehash());
+    assert(!m.auto_shrink());
+    assert(m.max_load_factor() == 0.5f);
+}
+
+int main() {
+    map_type src = make_source();
+    for (int i = 0; i != 500; ++i) src[i] = i;
+
+    map_type dst;
+    dst[7] = 7;
+    dst = src;
+    check_config(dst);
+    assert(dst.size() == 500);
+    for (int i = 0; i != 500; ++i) assert(dst.count(i) == 1);  // Hash没拷贝时按新的哈希值找不到
+    assert(dst.find(1042) != dst.end() && dst.find(1042)->second == 42);  // Equal也要拷贝
+
+    // 之后的插入和删除也按拷贝来的配置进行
+    dst.incremental_rehash(false);
+    for (int i = 500; i != 1000; ++i) dst[i] = i;
+    assert(dst.size() == 1000 && dst.load_factor() <= 0.5f);
+    size_t buckets = dst.bucket_count();
+    for (int i = 0; i != 990; ++i) dst.erase(dst.find(i));
+    assert(dst.bucket_count() == buckets);  // 不自动缩容
+
+    // 空的源也要拷贝配置
+    map_type empty = make_source();
+    map_type other;
+    other[1] = 1;
+    other = empty;
+    check_config(other);
+    assert(other.empty());
+    other[1042] = 1;
+    assert(other.count(42) == 1);
+
+    puts("ok");
+    return 0;
+}
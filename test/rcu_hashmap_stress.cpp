@@ -0,0 +1,83 @@
+// rcu_hashmap 多写者、多读者并发压力测试：读者读到的版本在读临界区内不能被释放，也不能被修改
+// 每个版本里所有值都相同且是堆上的字符串，版本被提前释放时 ASan 能报出来，读到半修改的版本时断言失败
+//     g++ -std=c++17 -O1 -g -pthread -fsanitize=address -I.. rcu_hashmap_stress.cpp && ./a.out
+//     g++ -std=c++17 -O1 -g -pthread -fsanitize=thread  -I.. rcu_hashmap_stress.cpp && ./a.out
+#undef NDEBUG  // 检查都写在 assert 里，任何编译选项下都要生效
+#include "rcu_hashmap.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int keys = 64;
+const int writers = 2;
+const int readers = 8;
+const int updates_per_writer = 2000;
+
+// 足够长，不会落进短字符串优化，值存放在堆上
+std::string make_value(long version) {
+    return std::string(40, 'v') + std::to_string(version);
+}
+
+int main() {
+    sjtu::rcu_hashmap<int, std::string> m;
+    m.update([](sjtu::rcu_hashmap<int, std::string>::map_type& map) {
+        for (int k = 0; k != keys; ++k) map[k] = make_value(0);
+    });
+
+    std::atomic<long> next_version(1);
+    std::atomic<int> writers_left(writers);
+    std::atomic<long> reads(0);
+    std::vector<std::thread> threads;
+
+    for (int w = 0; w != writers; ++w) {
+        threads.emplace_back([&] {
+            for (int i = 0; i != updates_per_writer; ++i) {
+                if (i % 10 == 0) {  // 偶尔整体替换，走 assign 路径
+                    sjtu::rcu_hashmap<int, std::string>::map_type map;
+                    long version = next_version.fetch_add(1);
+                    for (int k = 0; k != keys; ++k) map[k] = make_value(version);
+                    m.assign(std::move(map));
+                }
+                else {
+                    m.update([&](sjtu::rcu_hashmap<int, std::string>::map_type& map) {
+                        long version = next_version.fetch_add(1);
+                        for (int k = 0; k != keys; ++k) map[k] = make_value(version);
+                    });
+                }
+            }
+            --writers_left;
+        });
+    }
+
+    for (int r = 0; r != readers; ++r) {
+        threads.emplace_back([&, r] {
+            long n = 0;
+            while (writers_left.load() != 0) {
+                // 同一个版本里所有值都相同
+                bool consistent = m.read([](const sjtu::rcu_hashmap<int, std::string>::map_type& map) {
+                    if (map.size() != keys) return false;
+                    const std::string& first = map.at(0);
+                    for (int k = 1; k != keys; ++k) {
+                        if (map.at(k) != first) return false;
+                    }
+                    return true;
+                });
+                assert(consistent);
+                std::string value;
+                bool found = m.find(r % keys, value);
+                assert(found && value.compare(0, 40, std::string(40, 'v')) == 0);
+                ++n;
+            }
+            reads += n;
+        });
+    }
+
+    for (std::thread& t : threads) t.join();
+    size_t size = m.size();
+    assert(size == keys);
+    printf("ok: %ld versions, %ld reads\n", next_version.load() - 1, reads.load());
+    return 0;
+}
@@ -0,0 +1,78 @@
+// small_vector 的插入在元素拷贝抛异常时，容器内容不变，不泄漏、不析构未构造的内存
+//     g++ -std=c++17 -g -fsanitize=address,undefined -I.. small_vector_exception_safety.cpp && ./a.out
+#include "small_vector.hpp"
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+
+// 第 throw_after 次拷贝时抛异常；live 统计存活的对象数
+int live = 0;
+int throw_after = -1;
+
+// 拷贝可能抛异常，移动是 noexcept 的
+struct Copyable {
+    int* p;  // 堆上的值，泄漏或重复析构时 ASan 能报出来
+    explicit Copyable(int v) :p(new int(v)) { ++live; }
+    Copyable(const Copyable& o) {
+        if (throw_after == 0) throw std::runtime_error("copy");
+        if (throw_after > 0) --throw_after;
+        p = new int(*o.p);
+        ++live;
+    }
+    Copyable(Copyable&& o) noexcept :p(o.p) { o.p = nullptr; ++live; }
+    Copyable& operator=(const Copyable& o) { *p = *o.p; return *this; }
+    ~Copyable() { delete p; --live; }
+};
+
+template<class V>
+void check_unchanged(const V& v, int n) {
+    assert(int(v.size()) == n);
+    for (int i = 0; i != n; ++i) assert(*v[i].p == i);
+}
+
+// 在at处插入5个x，第3次拷贝抛异常
+template<class V>
+void insert_throws(V& v, int n, int at) {
+    Copyable x(100);
+    throw_after = 2;
+    bool thrown = false;
+    try { v.insert(v.begin() + at, 5, x); }
+    catch (std::runtime_error&) { thrown = true; }
+    throw_after = -1;
+    assert(thrown);
+    check_unchanged(v, n);
+    v.insert(v.begin() + at, 2, x);  // 之后还能正常使用
+    assert(int(v.size()) == n + 2 && *v[at].p == 100);
+}
+
+int main() {
+    for (int at : {0, 2, 4}) {
+        // 内联缓冲区，容量够用
+        {
+            sjtu::small_vector<Copyable, 16> v;
+            for (int i = 0; i != 4; ++i) v.emplace_back(i);
+            insert_throws(v, 4, at);
+        }
+        assert(live == 0);
+
+        // 堆上缓冲区，容量够用
+        {
+            sjtu::small_vector<Copyable, 2> v;
+            v.reserve(32);
+            for (int i = 0; i != 4; ++i) v.emplace_back(i);
+            insert_throws(v, 4, at);
+        }
+        assert(live == 0);
+
+        // 需要扩容，从内联缓冲区搬到堆上
+        {
+            sjtu::small_vector<Copyable, 4> v;
+            for (int i = 0; i != 4; ++i) v.emplace_back(i);
+            insert_throws(v, 4, at);
+        }
+        assert(live == 0);
+    }
+
+    puts("ok");
+    return 0;
+}
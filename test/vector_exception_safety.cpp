@@ -0,0 +1,132 @@
+// vector 的插入和扩容在元素拷贝/移动抛异常时，容器内容不变，不泄漏、不重复析构、不析构未构造的内存
+//     g++ -std=c++17 -g -fsanitize=address,undefined -I.. vector_exception_safety.cpp && ./a.out
+#include "vector.hpp"
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+
+// 第 throw_after 次拷贝（或移动）时抛异常；live 统计存活的对象数
+int live = 0;
+int throw_after = -1;
+
+void maybe_throw() {
+    if (throw_after == 0) throw std::runtime_error("copy");
+    if (throw_after > 0) --throw_after;
+}
+
+// 拷贝可能抛异常，移动是 noexcept 的
+struct Copyable {
+    int* p;  // 堆上的值，泄漏或重复析构时 ASan 能报出来
+    explicit Copyable(int v) :p(new int(v)) { ++live; }
+    Copyable(const Copyable& o) { maybe_throw(); p = new int(*o.p); ++live; }
+    Copyable(Copyable&& o) noexcept :p(o.p) { o.p = nullptr; ++live; }
+    Copyable& operator=(const Copyable& o) { *p = *o.p; return *this; }
+    ~Copyable() { delete p; --live; }
+};
+
+// 只能拷贝，扩容时旧元素也要拷贝过去
+struct CopyOnly {
+    int* p;
+    explicit CopyOnly(int v) :p(new int(v)) { ++live; }
+    CopyOnly(const CopyOnly& o) { maybe_throw(); p = new int(*o.p); ++live; }
+    CopyOnly& operator=(const CopyOnly& o) { *p = *o.p; return *this; }
+    ~CopyOnly() { delete p; --live; }
+};
+
+// 只能移动，且移动不是 noexcept
+struct MoveOnly {
+    int* p;
+    explicit MoveOnly(int v) :p(new int(v)) { ++live; }
+    MoveOnly(MoveOnly&& o) { maybe_throw(); p = o.p; o.p = nullptr; ++live; }
+    MoveOnly& operator=(MoveOnly&& o) { std::swap(p, o.p); return *this; }
+    ~MoveOnly() { delete p; --live; }
+};
+
+template<class V>
+void fill(V& v, int n) {
+    for (int i = 0; i != n; ++i) v.emplace_back(i);
+}
+
+template<class V>
+void check_unchanged(const V& v, int n) {
+    assert(int(v.size()) == n);
+    for (int i = 0; i != n; ++i) assert(*v[i].p == i);
+}
+
+template<class F>
+void expect_throw(F f) {
+    bool thrown = false;
+    try { f(); }
+    catch (std::runtime_error&) { thrown = true; }
+    throw_after = -1;
+    assert(thrown);
+}
+
+int main() {
+    // insert(pos, n, value)，容量够用：第3次拷贝抛异常
+    for (int at : {0, 3, 8}) {
+        {
+            sjtu::vector<Copyable> v;
+            v.reserve(32);
+            fill(v, 8);
+            Copyable x(100);
+            throw_after = 2;
+            expect_throw([&] { v.insert(v.begin() + at, 5, x); });
+            check_unchanged(v, 8);
+            v.insert(v.begin() + at, 2, x);  // 之后还能正常使用
+            assert(v.size() == 10 && *v[at].p == 100);
+        }
+        assert(live == 0);
+    }
+
+    // insert(pos, n, value)，需要扩容
+    {
+        sjtu::vector<Copyable> v;
+        fill(v, 4);
+        v.shrink_to_fit();
+        Copyable x(100);
+        throw_after = 2;
+        expect_throw([&] { v.insert(v.begin() + 2, 5, x); });
+        check_unchanged(v, 4);
+    }
+    assert(live == 0);
+
+    // resize(n, value) 扩容：填充元素的拷贝抛异常
+    {
+        sjtu::vector<Copyable> v;
+        fill(v, 4);
+        v.shrink_to_fit();
+        Copyable x(100);
+        throw_after = 3;
+        expect_throw([&] { v.resize(10, x); });
+        check_unchanged(v, 4);
+    }
+    assert(live == 0);
+
+    // resize(n, value) 扩容：填充成功后搬移旧元素时抛异常（旧元素只能拷贝）
+    {
+        sjtu::vector<CopyOnly> v;
+        fill(v, 4);
+        v.shrink_to_fit();
+        CopyOnly x(100);
+        throw_after = 6 + 2;  // 6个填充元素之后，第3个旧元素的拷贝
+        expect_throw([&] { v.resize(10, x); });
+        check_unchanged(v, 4);
+    }
+    assert(live == 0);
+
+    // 移动可能抛异常且不能拷贝的元素：只保证基本保证，但不能泄漏或析构未构造的内存
+    {
+        sjtu::vector<MoveOnly> v;
+        fill(v, 4);
+        v.shrink_to_fit();
+        throw_after = 2;
+        try { v.emplace_back(4); }
+        catch (std::runtime_error&) { }
+        throw_after = -1;
+    }
+    assert(live == 0);
+
+    puts("ok");
+    return 0;
+}
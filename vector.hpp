@@ -2,32 +2,330 @@
 #define VECTOR_H
 
 #include "exceptions.hpp"
+#include "config.hpp"
 
 #include<utility>
 #include<cstddef>
+#include<memory>
+#include<cstring>
+#include<type_traits>
+#include<iterator>
 
 namespace sjtu {
 
-template <class T>
+namespace detail {
+
+    // 可按字节搬移的类型：搬移时直接memcpy，不逐个调用构造/析构
+    template<class T>
+    struct is_trivially_relocatable : std::is_trivially_copyable<T> { };
+
+    // 能提前算出区间长度（多遍遍历）的迭代器；没有iterator_traits的迭代器（如本库list的）按单遍处理
+    template<class It, class = void>
+    struct is_forward_iterator : std::false_type { };
+
+    template<class It>
+    struct is_forward_iterator<It, std::void_t<typename std::iterator_traits<It>::iterator_category>>
+        : std::is_convertible<typename std::iterator_traits<It>::iterator_category, std::forward_iterator_tag> { };
+
+    // 区间构造/插入的模板参数不能是整数，否则会抢走 vector(n, value) 这样的调用
+    template<class It>
+    using enable_if_iterator = typename std::enable_if<!std::is_integral<It>::value>::type;
+
+    // It是指向T的指针：区间是连续的T，可能就在容器自己的缓冲区里
+    template<class It, class T>
+    struct is_pointer_to : std::integral_constant<bool, std::is_pointer<It>::value &&
+        std::is_same<typename std::remove_cv<typename std::remove_pointer<It>::type>::type, T>::value> { };
+
+    //把[src, src + n)搬到未初始化的dst（两段不重叠），并在dst的index处空出gap个位置：
+    //src[0, index)到dst[0, index)，src[index, n)到dst[index + gap, n + gap)；搬完后src处的对象已析构
+    //移动不抛异常时边移动边析构；否则先全部构造（能拷贝就拷贝，不能拷贝才移动），全部成功后再析构旧元素，
+    //中途失败时析构已构造的新元素，旧元素不受影响
+    template<class Alloc, class T>
+    void relocate_gap(Alloc& alloc, T* dst, T* src, size_t n, size_t index, size_t gap){
+        using alloc_traits = std::allocator_traits<Alloc>;
+        if(n == 0) return;
+        if constexpr (is_trivially_relocatable<T>::value){
+            std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), index * sizeof(T));
+            std::memcpy(static_cast<void*>(dst + index + gap), static_cast<const void*>(src + index), (n - index) * sizeof(T));
+        }
+        else if constexpr (std::is_nothrow_move_constructible<T>::value){
+            for(size_t i = 0; i != n; ++i){
+                alloc_traits::construct(alloc, dst + (i < index ? i : i + gap), std::move(*(src + i)));
+                alloc_traits::destroy(alloc, src + i);
+            }
+        }
+        else{
+            size_t i = 0;
+            try{
+                for(; i != n; ++i)
+                    alloc_traits::construct(alloc, dst + (i < index ? i : i + gap), std::move_if_noexcept(*(src + i)));
+            }
+            catch(...){
+                while(i != 0){
+                    --i;
+                    alloc_traits::destroy(alloc, dst + (i < index ? i : i + gap));
+                }
+                throw;
+            }
+            for(i = 0; i != n; ++i)
+                alloc_traits::destroy(alloc, src + i);
+        }
+    }
+
+    //不留空位的relocate_gap
+    template<class Alloc, class T>
+    void relocate(Alloc& alloc, T* dst, T* src, size_t n){
+        relocate_gap(alloc, dst, src, n, n, 0);
+    }
+
+    //同一块缓冲区内搬移，两段可以重叠；dst中不与src重叠的部分必须是未初始化的
+    template<class Alloc, class T>
+    void relocate_overlap(Alloc& alloc, T* dst, T* src, size_t n){
+        using alloc_traits = std::allocator_traits<Alloc>;
+        if(n == 0 || dst == src) return;
+        if constexpr (is_trivially_relocatable<T>::value){
+            std::memmove(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+        }
+        else if(dst < src){
+            for(size_t i = 0; i != n; ++i){
+                alloc_traits::construct(alloc, dst + i, std::move(*(src + i)));
+                alloc_traits::destroy(alloc, src + i);
+            }
+        }
+        else{
+            for(size_t i = n; i != 0; --i){
+                alloc_traits::construct(alloc, dst + i - 1, std::move(*(src + i - 1)));
+                alloc_traits::destroy(alloc, src + i - 1);
+            }
+        }
+    }
+
+    //从first开始拷贝n个元素到未初始化的dst，中途抛异常时析构已构造的部分
+    //指针区间且元素可平凡拷贝时直接memcpy
+    template<class Alloc, class T, class ForwardIt>
+    void construct_range(Alloc& alloc, T* dst, ForwardIt first, size_t n){
+        using alloc_traits = std::allocator_traits<Alloc>;
+        if constexpr (is_pointer_to<ForwardIt, T>::value && is_trivially_relocatable<T>::value){
+            if(n != 0) std::memcpy(static_cast<void*>(dst), static_cast<const void*>(first), n * sizeof(T));
+        }
+        else{
+            size_t i = 0;
+            try{
+                for(; i != n; ++i, ++first)
+                    alloc_traits::construct(alloc, dst + i, *first);
+            }
+            catch(...){
+                while(i != 0) alloc_traits::destroy(alloc, dst + --i);
+                throw;
+            }
+        }
+    }
+
+}
+
+//扩容/缩容策略：容量按 Num/Den 倍增长
+//grow(capacity, required)：返回至少能放下required个元素的新容量，第一次分配至少initial个
+//shrink(size, capacity)：返回缩容后的容量，不需要缩容时返回capacity
+//缩容带滞回：元素数降到 capacity/factor^2 以下才缩到 size*factor，
+//此后要再涨一个factor倍才会扩容，在边界附近来回push/pop不会反复重新分配
+//缩容不会低于initial，也不会释放缓冲区，要彻底释放用shrink_to_fit
+template <size_t Num, size_t Den, bool Shrink = true>
+struct geometric_growth{
+    static_assert(Num > Den && Den > 0, "growth factor must be greater than 1");
+
+    static constexpr size_t initial = 4;
+
+    static size_t grow(size_t capacity, size_t required){
+        if(capacity == 0) return required > initial ? required : initial;
+        size_t n = capacity / Den * Num + capacity % Den * Num / Den;
+        if(n <= capacity) n = capacity + 1;
+        return n < required ? required : n;
+    }
+
+    static size_t shrink(size_t size, size_t capacity){
+        if(!Shrink || capacity <= initial) return capacity;
+        if(size * Num * Num >= capacity * Den * Den) return capacity;
+        size_t n = size * Num / Den;
+        if(n < size) n = size;
+        return n < initial ? initial : n;
+    }
+};
+
+using growth_2x = geometric_growth<2, 1>;          // 默认：2倍扩容，低于1/4时缩到2倍
+using growth_1_5x = geometric_growth<3, 2>;        // 1.5倍扩容，省内存，旧块更容易被复用
+using growth_no_shrink = geometric_growth<2, 1, false>;  // 2倍扩容，erase从不缩容
+
+template <class T, class Allocator = std::allocator<T>, class Growth = growth_2x>
 class vector{
 
 public:
 
     using value_type = T;
+    using allocator_type = Allocator;
     using iterator = value_type*;
     using const_iterator = const value_type*;
     using size_type = size_t;
 
 private:
 
+    using alloc_traits = std::allocator_traits<Allocator>;
+    static_assert(std::is_same<typename alloc_traits::value_type, T>::value,
+        "allocator_type::value_type must be T");
+    static_assert(std::is_same<typename alloc_traits::pointer, T*>::value,
+        "only allocators with raw pointers are supported");
+
+    Allocator alloc_;
     iterator begin_;
     size_type currentsize_ = 0;
     size_type maxsize_;
 
+    iterator _allocate(size_type n){
+        return n == 0 ? nullptr : alloc_traits::allocate(alloc_, n);
+    }
+
+    void _deallocate(iterator p, size_type n){
+        if(p) alloc_traits::deallocate(alloc_, p, n);
+    }
+
+    void _relocate(iterator dst, iterator src, size_type n){
+        detail::relocate(alloc_, dst, src, n);
+    }
+
+    void _relocate_gap(iterator dst, iterator src, size_type n, size_type index, size_type gap){
+        detail::relocate_gap(alloc_, dst, src, n, index, gap);
+    }
+
+    void _relocate_overlap(iterator dst, iterator src, size_type n){
+        detail::relocate_overlap(alloc_, dst, src, n);
+    }
+
+    template<class ForwardIt>
+    void _construct_range(iterator dst, ForwardIt first, size_type n){
+        detail::construct_range(alloc_, dst, first, n);
+    }
+
+    template<class It>
+    static constexpr bool _is_value_pointer = detail::is_pointer_to<It, T>::value;
+
+    //在index处插入[first, first + n)，先算好最终大小，最多分配一次
+    template<class ForwardIt>
+    iterator _insert_range(size_type index, ForwardIt first, size_type n){
+        if(n == 0) return begin_ + index;
+        if(currentsize_ + n <= maxsize_){
+            _relocate_overlap(begin_ + index + n, begin_ + index, currentsize_ - index);
+            try{
+                _construct_range(begin_ + index, first, n);
+            }
+            catch(...){  // 把挪走的元素挪回来
+                _relocate_overlap(begin_ + index, begin_ + index + n, currentsize_ - index);
+                throw;
+            }
+        }
+        else{
+            size_type new_maxsize_ = Growth::grow(maxsize_, currentsize_ + n);
+            iterator temp_begin_ = _allocate(new_maxsize_);
+            try{
+                _construct_range(temp_begin_ + index, first, n);
+            }
+            catch(...){
+                _deallocate(temp_begin_, new_maxsize_);
+                throw;
+            }
+            try{
+                _relocate_gap(temp_begin_, begin_, currentsize_, index, n);
+            }
+            catch(...){  // 旧元素不受影响，丢掉已构造的插入区间和新缓冲区
+                for(size_type i = index; i != index + n; ++i) alloc_traits::destroy(alloc_, temp_begin_ + i);
+                _deallocate(temp_begin_, new_maxsize_);
+                throw;
+            }
+            _deallocate(begin_, maxsize_);
+            begin_ = temp_begin_;
+            maxsize_ = new_maxsize_;
+        }
+        currentsize_ += n;
+        return begin_ + index;
+    }
+
+    //换一块容量为n的缓冲区，把现有元素搬过去
+    void _reallocate(size_type n){
+        iterator temp_begin_ = _allocate(n);
+        try{
+            _relocate(temp_begin_, begin_, currentsize_);
+        }
+        catch(...){
+            _deallocate(temp_begin_, n);
+            throw;
+        }
+        _deallocate(begin_, maxsize_);
+        begin_ = temp_begin_;
+        maxsize_ = n;
+    }
+
+    //参数恰好是一个T的右值：可以直接构造到目标位置，不必先构造临时对象
+    template<class... Args>
+    struct _is_self_rvalue : std::false_type { };
+
+    template<class U>
+    struct _is_self_rvalue<U> : std::integral_constant<bool,
+        !std::is_lvalue_reference<U>::value &&
+        std::is_same<typename std::remove_cv<typename std::remove_reference<U>::type>::type, value_type>::value> { };
+
+    //扩容并在index处构造元素：先在新缓冲区构造（参数可能引用旧缓冲区中的元素），再搬旧元素
+    template<class... Args>
+    void _realloc_emplace(size_type index, Args&&... args){
+        size_type n = Growth::grow(maxsize_, currentsize_ + 1);
+        iterator temp_begin_ = _allocate(n);
+        try{
+            alloc_traits::construct(alloc_, temp_begin_ + index, std::forward<Args>(args)...);
+        }
+        catch(...){
+            _deallocate(temp_begin_, n);
+            throw;
+        }
+        try{
+            _relocate_gap(temp_begin_, begin_, currentsize_, index, 1);
+        }
+        catch(...){
+            alloc_traits::destroy(alloc_, temp_begin_ + index);
+            _deallocate(temp_begin_, n);
+            throw;
+        }
+        _deallocate(begin_, maxsize_);
+        begin_ = temp_begin_;
+        maxsize_ = n;
+        ++currentsize_;
+    }
+
+    //在index处原地构造一个元素
+    template<class... Args>
+    iterator _emplace(size_type index, Args&&... args){
+        if(currentsize_ == maxsize_){
+            _realloc_emplace(index, std::forward<Args>(args)...);
+        }
+        else if(index == currentsize_){
+            alloc_traits::construct(alloc_, begin_ + index, std::forward<Args>(args)...);
+            ++currentsize_;
+        }
+        else if constexpr (_is_self_rvalue<Args...>::value){
+            _relocate_overlap(begin_ + index + 1, begin_ + index, currentsize_ - index);
+            alloc_traits::construct(alloc_, begin_ + index, std::forward<Args>(args)...);
+            ++currentsize_;
+        }
+        else{
+            //参数可能引用要挪动的元素，先构造好再挪
+            value_type temp(std::forward<Args>(args)...);
+            _relocate_overlap(begin_ + index + 1, begin_ + index, currentsize_ - index);
+            alloc_traits::construct(alloc_, begin_ + index, std::move(temp));
+            ++currentsize_;
+        }
+        return begin_ + index;
+    }
+
     void destroy(){
         for (size_type i = 0; i != currentsize_; i++)
-            (begin_+i)->~T();
-        operator delete(begin_);
+            alloc_traits::destroy(alloc_, begin_+i);
+        _deallocate(begin_, maxsize_);
         begin_ = nullptr;
         maxsize_ = 0;
         currentsize_ = 0;
@@ -37,36 +335,63 @@ public:
 
 #pragma region default constructor, copy constructor, Destructor
 
-    vector():maxsize_(10) {
-        begin_ = static_cast<T*>(operator new(10 * sizeof(T)));
+    //空的vector不分配内存，第一次插入时才分配
+    vector() noexcept(noexcept(Allocator())):vector(Allocator()) { }
+
+    explicit vector(const Allocator& alloc) noexcept:alloc_(alloc), begin_(nullptr), maxsize_(0) { }
+
+    vector(size_type n, const Allocator& alloc = Allocator()):alloc_(alloc), maxsize_(n){
+        begin_ = _allocate(maxsize_);
     }
 
-    vector(size_type n){
-        maxsize_ = n > 10 ? n : 10;
-        begin_ = static_cast<T*>(operator new(maxsize_ * sizeof(T)));
+    vector(size_type n, const value_type& value, const Allocator& alloc = Allocator()):alloc_(alloc), maxsize_(n){
+        begin_ = _allocate(maxsize_);
+        for(; currentsize_ != n; currentsize_++){
+            alloc_traits::construct(alloc_, begin_ + currentsize_, value);
+        }
     }
 
-    vector(size_type n, const value_type& value){
-        maxsize_ = n > 10 ? n : 10;
-        currentsize_ = n;
-        begin_ = static_cast<T*>(operator new(maxsize_ * sizeof(T)));
-        for(size_type i = 0; i != n; i++){
-            new (begin_ + i) value_type(value);
+    template<class InputIt, class = detail::enable_if_iterator<InputIt>>
+    vector(InputIt first, InputIt last, const Allocator& alloc = Allocator()):alloc_(alloc){
+        if constexpr (detail::is_forward_iterator<InputIt>::value){
+            size_type n = std::distance(first, last);
+            maxsize_ = n;
+            begin_ = _allocate(maxsize_);
+            try{
+                _construct_range(begin_, first, n);
+            }
+            catch(...){
+                _deallocate(begin_, maxsize_);
+                throw;
+            }
+            currentsize_ = n;
+        }
+        else{
+            maxsize_ = 0;
+            begin_ = nullptr;
+            try{
+                for(; first != last; ++first) emplace_back(*first);
+            }
+            catch(...){
+                destroy();
+                throw;
+            }
         }
     }
 
     vector(const vector& rhs):
-        currentsize_(rhs.currentsize_), maxsize_(rhs.maxsize_) {
-        begin_ = static_cast<T*>(operator new(maxsize_ * sizeof(T)));
-        for(size_type i = 0; i != rhs.size(); i++){
-            new (begin_ + i) value_type(*(rhs.begin_ + i));
+        alloc_(alloc_traits::select_on_container_copy_construction(rhs.alloc_)), maxsize_(rhs.size()) {
+        begin_ = _allocate(maxsize_);
+        for(; currentsize_ != rhs.size(); currentsize_++){
+            alloc_traits::construct(alloc_, begin_ + currentsize_, *(rhs.begin_ + currentsize_));
         }
     }
 
-    vector(vector&& rhs):
-        currentsize_(rhs.currentsize_), maxsize_(rhs.maxsize_){
+    vector(vector&& rhs) noexcept:
+        alloc_(std::move(rhs.alloc_)), currentsize_(rhs.currentsize_), maxsize_(rhs.maxsize_){
         begin_ = rhs.begin_;
         rhs.begin_ = nullptr;
+        rhs.currentsize_ = rhs.maxsize_ = 0;
     }
 
     ~vector(){
@@ -79,34 +404,57 @@ public:
     vector& operator=(const vector& rhs) {
         if(this == &rhs)return *this;
 
+        if constexpr (alloc_traits::propagate_on_container_copy_assignment::value){
+            if(alloc_ != rhs.alloc_) destroy();  // 旧内存必须用旧的分配器释放
+            alloc_ = rhs.alloc_;
+        }
         size_type len = rhs.size();
-        if(size() < len){
+        if(capacity() < len){
             destroy();
+            begin_ = _allocate(rhs.capacity());
             maxsize_ = rhs.capacity();
-            currentsize_ = len;
-            begin_ = static_cast<T*>(operator new(maxsize_ * sizeof(T)));
-            for(size_type i = 0; i!= len; ++i){
-                new (begin_ + i) value_type(*(rhs.begin_ + i));   
+            for(; currentsize_ != len; currentsize_++){
+                alloc_traits::construct(alloc_, begin_ + currentsize_, *(rhs.begin_ + currentsize_));
             }
         }
         else{
-            currentsize_ = len;
-            for(size_type i = 0; i!= len; ++i){
+            size_type common = len < size() ? len : size();
+            for(size_type i = 0; i != common; ++i){
                 *(begin_ + i) = *(rhs.begin_ + i);
             }
-            for(size_type i = len; i!= size(); ++i){
-                (begin_ + i)->~T();
+            for(size_type i = len; i < size(); ++i){
+                alloc_traits::destroy(alloc_, begin_ + i);
+            }
+            for(; currentsize_ < len; currentsize_++){
+                alloc_traits::construct(alloc_, begin_ + currentsize_, *(rhs.begin_ + currentsize_));
             }
+            currentsize_ = len;
         }
         return *this;
     }
 
-    vector& operator=(vector&& rhs) {
+    vector& operator=(vector&& rhs) noexcept(
+        alloc_traits::propagate_on_container_move_assignment::value || alloc_traits::is_always_equal::value) {
+        if(this == &rhs)return *this;
+        if constexpr (!alloc_traits::propagate_on_container_move_assignment::value &&
+                      !alloc_traits::is_always_equal::value){
+            if(alloc_ != rhs.alloc_){  // 分配器不同，不能接管对方的内存，只能逐个移动
+                clear();
+                reserve(rhs.size());
+                for(size_type i = 0; i != rhs.size(); ++i)
+                    emplace_back(std::move(*(rhs.begin_ + i)));
+                rhs.clear();
+                return *this;
+            }
+        }
         destroy();
+        if constexpr (alloc_traits::propagate_on_container_move_assignment::value)
+            alloc_ = std::move(rhs.alloc_);
         maxsize_ = rhs.maxsize_;
         currentsize_ = rhs.currentsize_;
         begin_ = rhs.begin_;
         rhs.begin_ = nullptr;
+        rhs.currentsize_ = rhs.maxsize_ = 0;
         return *this;
     }
 #pragma endregion
@@ -156,7 +504,7 @@ public:
 
     void clear(){
         for (size_type i = 0; i != currentsize_; i++)
-            (begin_+i)->~T();
+            alloc_traits::destroy(alloc_, begin_+i);
         currentsize_ = 0;
     }
 #pragma endregion
@@ -164,70 +512,72 @@ public:
     //扩容
     void reserve(size_type n){
         if(n <= capacity()) return;
-        iterator temp_begin_ = static_cast<T*>(operator new(n * sizeof(T)));
-        for(size_type i = 0; i != size(); i++){
-            new (temp_begin_ + i) value_type(*(begin_ + i));
-            (begin_+i)->~T();
-        }
-        operator delete(begin_);
-        begin_ = temp_begin_;
-        maxsize_ = n;
+        _reallocate(n);
     }
 
     //缩容到数据数量
     void shrink_to_fit(){
-        iterator temp_begin_ = static_cast<T*>(operator new(size() * sizeof(T)));
-        for(size_type i = 0; i != size(); i++){
-            new (temp_begin_ + i) value_type(*(begin_ + i));
-            (begin_+i)->~T();
-        }
-        operator delete(begin_);
-        begin_ = temp_begin_;
-        maxsize_ = size();
+        if(size() == capacity()) return;
+        _reallocate(size());
     }
 
     //扩容并填充数据
     void assign(size_type n, const T& value){
         if(n > capacity()){
-            iterator temp_begin_ = static_cast<T*>(operator new(n * sizeof(T)));
-            for(size_type i = 0; i != n; i++){
-                new (temp_begin_ + i) value_type(value);
+            iterator temp_begin_ = _allocate(n);
+            size_type i = 0;
+            try{
+                for(; i != n; i++){
+                    alloc_traits::construct(alloc_, temp_begin_ + i, value);
+                }
             }
-            for(size_type i = 0; i != size(); i++){
-                (begin_+i)->~T();
+            catch(...){
+                while(i != 0) alloc_traits::destroy(alloc_, temp_begin_ + --i);
+                _deallocate(temp_begin_, n);
+                throw;
             }
-            operator delete(begin_);
+            destroy();
             begin_ = temp_begin_;
-            maxsize_ = size();
-            currentsize_ = size();
+            maxsize_ = n;
+            currentsize_ = n;
+        }
+        else{
+            resize(0, value);
+            resize(n, value);
         }
     }
 
     //改变容量，多了则填充数据
     void resize(size_type n, const value_type& value){
         if(n > capacity()){
-            iterator temp_begin_ = static_cast<T*>(operator new(n * sizeof(T)));
-            for(size_type i = 0; i != size(); i++){
-                new (temp_begin_ + i) value_type(*(begin_ + i));
-                (begin_+i)->~T();
+            //先构造新元素（value可能就是本容器里的元素），再把旧元素搬过去
+            iterator temp_begin_ = _allocate(n);
+            size_type i = size();
+            try{
+                for(; i != n; i++){
+                    alloc_traits::construct(alloc_, temp_begin_ + i, value);
+                }
+                _relocate(temp_begin_, begin_, size());
             }
-            for(size_type i = size(); i != n; i++){
-                new (temp_begin_ + i) value_type(value);
+            catch(...){  // 填充的元素构造失败，或搬移旧元素失败（旧元素不受影响）
+                while(i != size()) alloc_traits::destroy(alloc_, temp_begin_ + --i);
+                _deallocate(temp_begin_, n);
+                throw;
             }
-            operator delete(begin_);
+            _deallocate(begin_, maxsize_);
             begin_ = temp_begin_;
             maxsize_ = n;
             currentsize_ = n;
         }
         else if(n < size()){
             for(size_type i = n; i != size(); i++){
-                (begin_+i)->~T();
+                alloc_traits::destroy(alloc_, begin_+i);
             }
             currentsize_ = n;
         }
         else {
             for(size_type i = size(); i != n; i++){
-                new (begin_ + i) value_type(value);
+                alloc_traits::construct(alloc_, begin_ + i, value);
             }
             currentsize_ = n;
         }
@@ -240,13 +590,18 @@ public:
 
  #pragma region 访问元素
 
+    //默认不检查越界（见config.hpp中的SJTU_CHECKED_SUBSCRIPT），要检查用at()
     value_type& operator[](size_type n) {
-        if(n >= size()) throw index_out_of_bound();//正常STL不需要
+#if SJTU_CHECKED_SUBSCRIPT
+        if(n >= size()) throw index_out_of_bound();
+#endif
         return *(begin_ + n);
     }
 
     const value_type& operator[](size_type n) const {
-        if(n >= size()) throw index_out_of_bound();//正常STL不需要
+#if SJTU_CHECKED_SUBSCRIPT
+        if(n >= size()) throw index_out_of_bound();
+#endif
         return *(begin_+ n);
     }
 
@@ -287,42 +642,57 @@ public:
     }
 #pragma endregion
 
- #pragma region 插入 insert()
+ #pragma region 插入 insert(), emplace()
     iterator insert(const_iterator pos, size_type n, const value_type& value){
         //if(pos < begin_ || pos > begin_ + currentsize_)throw
-        iterator xpos = const_cast<iterator>(pos);//留后门
-        size_type index = xpos - begin_;
+        size_type index = pos - begin_;
+        if(n == 0) return begin_ + index;
         if(currentsize_ + n <= maxsize_){
-            for(size_type i = size() + n - 1; i != index + n - 1; --i){
-                new (begin_ + i) value_type(*(begin_ + i - n));
-                (begin_ + i - n)->~T();
+            if(&value >= begin_ && &value < end()){  // value在要挪动的区间里，先拷一份
+                value_type temp(value);
+                return insert(pos, n, temp);
             }
-            for(size_type i = index; i != index + n; ++i){
-                new (begin_ + i) value_type(value);
+            _relocate_overlap(begin_ + index + n, begin_ + index, currentsize_ - index);
+            size_type i = index;
+            try{
+                for(; i != index + n; ++i){
+                    alloc_traits::construct(alloc_, begin_ + i, value);
+                }
+            }
+            catch(...){  // 析构已构造的部分，把挪走的元素挪回来
+                while(i != index) alloc_traits::destroy(alloc_, begin_ + --i);
+                _relocate_overlap(begin_ + index, begin_ + index + n, currentsize_ - index);
+                throw;
             }
-            currentsize_ += n;
         }
         else{
-            maxsize_ += maxsize_ > n ? maxsize_ : n * 2;
-            iterator temp_begin_ = static_cast<T*>(operator new(maxsize_ * sizeof(T)));
-            for(size_type i = size() + n - 1; i != index + n - 1; --i){
-                new (temp_begin_ + i) value_type(*(begin_ + i - n));
-                (begin_ + i - n)->~T();
+            size_type new_maxsize_ = Growth::grow(maxsize_, currentsize_ + n);
+            iterator temp_begin_ = _allocate(new_maxsize_);
+            size_type i = index;
+            try{
+                for(; i != index + n; ++i){
+                    alloc_traits::construct(alloc_, temp_begin_ + i, value);
+                }
             }
-
-            for(size_type i = index; i != index + n; ++i){
-                new (temp_begin_ + i) value_type(value);
+            catch(...){
+                while(i != index) alloc_traits::destroy(alloc_, temp_begin_ + --i);
+                _deallocate(temp_begin_, new_maxsize_);
+                throw;
             }
-
-            for(size_type i = 0; i != index; ++i){
-                new (temp_begin_ + i) value_type(*(begin_ + i));
-                (begin_+i)->~T();
+            try{
+                _relocate_gap(temp_begin_, begin_, currentsize_, index, n);
+            }
+            catch(...){  // 旧元素不受影响，丢掉新缓冲区
+                for(i = index; i != index + n; ++i) alloc_traits::destroy(alloc_, temp_begin_ + i);
+                _deallocate(temp_begin_, new_maxsize_);
+                throw;
             }
-            operator delete(begin_);
+            _deallocate(begin_, maxsize_);
             begin_ = temp_begin_;
-            currentsize_ += n;
+            maxsize_ = new_maxsize_;
         }
-        return begin_ + index + 1;
+        currentsize_ += n;
+        return begin_ + index;
     }
 
     iterator insert(const_iterator pos, const value_type& x) {
@@ -330,21 +700,67 @@ public:
     }
 
     iterator insert(const_iterator pos, T&& x) {
-        return insert(pos, 1, const_cast<const value_type &>(x));
+        return _emplace(pos - begin_, std::move(x));
+    }
+
+    //插入[first, last)，返回指向第一个插入元素的迭代器
+    template<class InputIt, class = detail::enable_if_iterator<InputIt>>
+    iterator insert(const_iterator pos, InputIt first, InputIt last) {
+        size_type index = pos - begin_;
+        if constexpr (detail::is_forward_iterator<InputIt>::value){
+            if constexpr (_is_value_pointer<InputIt>){
+                if(first != last && &*first < end() && begin_ < &*first + (last - first)){
+                    vector temp(first, last, alloc_);  // 区间来自本容器，先拷出来
+                    return _insert_range(index, temp.begin_, temp.size());
+                }
+            }
+            return _insert_range(index, first, std::distance(first, last));
+        }
+        else if(index == currentsize_){
+            for(; first != last; ++first) emplace_back(*first);
+            return begin_ + index;
+        }
+        else{
+            vector temp(first, last, alloc_);  // 单遍迭代器不知道长度，先收集起来
+            return _insert_range(index, std::make_move_iterator(temp.begin_), temp.size());
+        }
+    }
+
+    template<class... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        return _emplace(pos - begin_, std::forward<Args>(args)...);
     }
 #pragma endregion
 
-#pragma region push(), pop()
+#pragma region push(), emplace_back(), pop()
     void push_back(const T& x) {
-        insert(end(), x);
+        emplace_back(x);
     }
     void push_back(T&& x) {
-        insert(end(), const_cast<const value_type &>(x));
+        emplace_back(std::move(x));
+    }
+
+    //把[first, last)接到末尾
+    template<class InputIt, class = detail::enable_if_iterator<InputIt>>
+    void append(InputIt first, InputIt last) {
+        insert(end(), first, last);
+    }
+
+    //末尾有空位时直接构造，不走insert的挪动逻辑
+    template<class... Args>
+    value_type& emplace_back(Args&&... args) {
+        if(currentsize_ == maxsize_)
+            _realloc_emplace(currentsize_, std::forward<Args>(args)...);
+        else{
+            alloc_traits::construct(alloc_, begin_ + currentsize_, std::forward<Args>(args)...);
+            ++currentsize_;
+        }
+        return *(begin_ + currentsize_ - 1);
     }
     void pop_back(){
         if(size() == 0) throw container_is_empty();//空
         if(currentsize_ == 0)return;
-        (end() - 1)->~T();
+        alloc_traits::destroy(alloc_, end() - 1);
         --currentsize_;
     }
 #pragma endregion
@@ -352,38 +768,38 @@ public:
 #pragma region 删除 erase()
     iterator erase(const_iterator first, const_iterator last){
         //if(!(first >= cbegin() && last <= cend() && first <= last))throw
-        if(first == last) return end();
         iterator xfirst = const_cast<iterator>(first);//留后门
         iterator xlast = const_cast<iterator>(last);//留后门
         size_type delta = xfirst - cbegin();
+        if(first == last) return begin_ + delta;
         size_type n = last - first;
         for(size_type i = 0; i != size() - n - delta; ++i){
-            *(xfirst + i + 1) = *(xlast + i + 1);
+            *(xfirst + i) = std::move(*(xlast + i));
         }
         for(size_type i = size() - n; i != size(); ++i){
-            (begin_ + i)->~T();
+            alloc_traits::destroy(alloc_, begin_ + i);
         }
         currentsize_ -= n;
-        if(size() < capacity()/4){
-            maxsize_ = currentsize_ * 2;
-            iterator temp_begin_ = static_cast<T*>(operator new(maxsize_ * sizeof(T)));
-            for(size_type i = 0; i != size(); ++i){
-                new (temp_begin_ + i) value_type(*(begin_ + i));
-                (begin_ + i)->~T();
-            }
-            operator delete(begin_);
-            begin_ = temp_begin_;
+        size_type new_maxsize_ = Growth::shrink(currentsize_, maxsize_);
+        if(new_maxsize_ != maxsize_){
+            _reallocate(new_maxsize_);
         }
-        return begin_ + delta + 1;
+        return begin_ + delta;
     }
 
     iterator erase(const_iterator pos){
-        return erase(pos - 1, pos);
+        return erase(pos, pos + 1);
     }
 #pragma endregion
 
+    allocator_type get_allocator() const {
+        return alloc_;
+    }
+
     void swap(vector& rhs) {
         if (this != &rhs) {
+            if constexpr (alloc_traits::propagate_on_container_swap::value)
+                std::swap(alloc_, rhs.alloc_);
             std::swap(begin_, rhs.begin_);
             std::swap(currentsize_, rhs.currentsize_);
             std::swap(maxsize_, rhs.maxsize_);